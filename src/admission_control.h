@@ -0,0 +1,156 @@
+// src/admission_control.h
+#pragma once
+
+#include "cache_line.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// how much a scheduler may hold at once (0 = no limit)
+struct AdmissionLimits {
+    size_t max_tasks = 0;
+    size_t max_bytes = 0; // estimated: sizeof(Task) plus Task::setMemoryEstimate() per task
+};
+
+// Capacity for submitted tasks, counted in tasks and in estimated bytes. While there is room
+// and nobody waits, admission is two atomic adds. Producers that do not fit queue up and are
+// admitted strictly in arrival order as finished tasks hand capacity back: a later, smaller
+// request never overtakes a waiting one. A request larger than the whole limit is admitted
+// once nothing else is held, so it cannot wait forever.
+class AdmissionControl {
+private:
+    struct Waiter {
+        size_t tasks;
+        size_t bytes;
+        bool admitted = false;
+        std::condition_variable condition;
+    };
+
+    AdmissionLimits limits_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tasks_{0};
+    std::atomic<size_t> bytes_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> num_waiting_{0};
+    std::mutex mutex_;
+    std::deque<Waiter*> waiters_; // FIFO, guarded by mutex_
+
+    bool fits(size_t old_tasks, size_t old_bytes, size_t tasks, size_t bytes) const {
+        if (old_tasks == 0 && old_bytes == 0) {
+            return true;
+        }
+        return (limits_.max_tasks == 0 || old_tasks + tasks <= limits_.max_tasks) &&
+               (limits_.max_bytes == 0 || old_bytes + bytes <= limits_.max_bytes);
+    }
+
+    // optimistic: adds first and takes it back if it does not fit. A concurrent reservation
+    // may fail spuriously because of the overshoot; it then queues and is admitted by the
+    // pass that follows.
+    bool reserve(size_t tasks, size_t bytes) {
+        size_t old_tasks = tasks_.fetch_add(tasks, std::memory_order_seq_cst);
+        size_t old_bytes = bytes_.fetch_add(bytes, std::memory_order_seq_cst);
+        if (fits(old_tasks, old_bytes, tasks, bytes)) {
+            return true;
+        }
+        tasks_.fetch_sub(tasks, std::memory_order_seq_cst);
+        bytes_.fetch_sub(bytes, std::memory_order_seq_cst);
+        return false;
+    }
+
+    // admits waiters from the front while they fit (called with mutex_ held)
+    void admitWaiters() {
+        while (!waiters_.empty() && reserve(waiters_.front()->tasks, waiters_.front()->bytes)) {
+            Waiter* waiter = waiters_.front();
+            waiters_.pop_front();
+            num_waiting_.fetch_sub(1, std::memory_order_seq_cst);
+            waiter->admitted = true;
+            waiter->condition.notify_one();
+        }
+    }
+
+public:
+    // disable copying
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    // Constructor
+    AdmissionControl() = default;
+
+    // Getters
+    bool limited() const {
+        return limits_.max_tasks != 0 || limits_.max_bytes != 0;
+    }
+    const AdmissionLimits& getLimits() const {
+        return limits_;
+    }
+    size_t tasksInUse() const {
+        return tasks_.load(std::memory_order_acquire);
+    }
+    size_t bytesInUse() const {
+        return bytes_.load(std::memory_order_acquire);
+    }
+    // producers blocked in acquire()
+    size_t waiting() const {
+        return num_waiting_.load(std::memory_order_acquire);
+    }
+
+    // Setter (only while nothing is held or waiting)
+    void setLimits(const AdmissionLimits& limits) {
+        limits_ = limits;
+    }
+
+    // Takes capacity for tasks / bytes, waiting in line until deadline if it is not available
+    // (time_point::max() = as long as it takes, min() = not at all); false on timeout.
+    bool acquire(size_t tasks, size_t bytes,
+                 std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        if (num_waiting_.load(std::memory_order_seq_cst) == 0 && reserve(tasks, bytes)) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        // a pass first: capacity may have come back (or our failed attempt held back someone)
+        admitWaiters();
+        if (waiters_.empty() && reserve(tasks, bytes)) {
+            return true;
+        }
+        if (deadline <= std::chrono::steady_clock::now()) {
+            return false;
+        }
+        Waiter waiter;
+        waiter.tasks = tasks;
+        waiter.bytes = bytes;
+        waiters_.push_back(&waiter);
+        num_waiting_.fetch_add(1, std::memory_order_seq_cst);
+        // released capacity that was returned before we counted as waiting
+        admitWaiters();
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            waiter.condition.wait(lock, [&waiter]() { return waiter.admitted; });
+            return true;
+        }
+        if (waiter.condition.wait_until(lock, deadline, [&waiter]() { return waiter.admitted; })) {
+            return true;
+        }
+        waiters_.erase(std::find(waiters_.begin(), waiters_.end(), &waiter));
+        num_waiting_.fetch_sub(1, std::memory_order_seq_cst);
+        // the ones behind us may fit where we did not
+        admitWaiters();
+        return false;
+    }
+
+    // takes capacity without waiting, even beyond the limit (for submissions that must not block)
+    void force(size_t tasks, size_t bytes) {
+        tasks_.fetch_add(tasks, std::memory_order_seq_cst);
+        bytes_.fetch_add(bytes, std::memory_order_seq_cst);
+    }
+
+    // hands capacity back and admits waiting producers in order
+    void release(size_t tasks, size_t bytes) {
+        tasks_.fetch_sub(tasks, std::memory_order_seq_cst);
+        bytes_.fetch_sub(bytes, std::memory_order_seq_cst);
+        if (num_waiting_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            admitWaiters();
+        }
+    }
+};
@@ -0,0 +1,125 @@
+// src/blocking_lane.h
+#pragma once
+
+#include "task.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+// Elastic set of threads for tasks that block (Task::setBlocking: file reads, network,
+// sleeps), so they do not sit on the CPU workers. Threads are started on demand up to
+// max_threads and exit after idling for keep_alive; at the limit tasks queue (FIFO).
+// The dependents a blocking task releases go to its owner as usual, i.e. back to the CPU pool.
+class BlockingLane {
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_; // idle threads wait here
+    std::condition_variable exited_;    // the destructor waits here for the last thread
+    std::deque<Task*> queue_;
+    size_t max_threads_;
+    std::chrono::milliseconds keep_alive_;
+    size_t num_threads_ = 0;
+    size_t num_idle_ = 0;
+    size_t peak_threads_ = 0;
+    bool stop_ = false;
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        peak_threads_ = std::max(peak_threads_, num_threads_);
+        while (true) {
+            if (!queue_.empty()) {
+                Task* task = queue_.front();
+                queue_.pop_front();
+                lock.unlock();
+                task->execute();
+                lock.lock();
+                continue;
+            }
+            if (stop_) {
+                break;
+            }
+            ++num_idle_;
+            bool woken = condition_.wait_for(lock, keep_alive_, [this]() {
+                return stop_ || !queue_.empty();
+            });
+            --num_idle_;
+            if (!woken) {
+                break; // idle for keep_alive
+            }
+        }
+        // last access to the lane (under the lock, the destructor waits for it)
+        --num_threads_;
+        exited_.notify_all();
+    }
+
+public:
+    // disable copying
+    BlockingLane(const BlockingLane&) = delete;
+    BlockingLane& operator=(const BlockingLane&) = delete;
+
+    // Constructor (no thread is started until the first task arrives)
+    BlockingLane(size_t max_threads, std::chrono::milliseconds keep_alive):
+        max_threads_(max_threads),
+        keep_alive_(keep_alive)
+    {}
+
+    // Destructor (see shutdown)
+    ~BlockingLane() {
+        shutdown();
+    }
+
+    // Runs the queued tasks, then waits until every thread left. The lane stays usable:
+    // a later submit starts a thread that exits once the queue is empty.
+    void shutdown() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+        condition_.notify_all();
+        exited_.wait(lock, [this]() { return num_threads_ == 0; });
+    }
+
+    // Getters (threads alive now / at most so far)
+    size_t numThreads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_threads_;
+    }
+    size_t peakThreads() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_threads_;
+    }
+
+    // any thread: an idle thread takes the task, else a new one is started (below the limit)
+    void submit(Task* task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(task);
+            if (queue_.size() <= num_idle_) {
+                condition_.notify_one();
+                return;
+            }
+            if (num_threads_ >= max_threads_) {
+                return;
+            }
+            ++num_threads_; // taken before the lock is dropped, so the limit holds
+        }
+        try {
+            std::thread([this]() { threadLoop(); }).detach();
+        } catch (const std::system_error&) {
+            // no thread: the queue waits for a running one, without any it is run right here
+            std::unique_lock<std::mutex> lock(mutex_);
+            --num_threads_;
+            exited_.notify_all();
+            while (num_threads_ == 0 && !queue_.empty()) {
+                Task* queued = queue_.front();
+                queue_.pop_front();
+                lock.unlock();
+                queued->execute();
+                lock.lock();
+            }
+        }
+    }
+};
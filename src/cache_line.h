@@ -0,0 +1,36 @@
+// src/cache_line.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// size used to keep independently written data on separate cache lines
+// (std::hardware_destructive_interference_size is not reliably available)
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// small number of the calling thread, for picking one of several shards of a structure
+// that many threads write (threads are numbered in the order they first ask)
+inline size_t threadShard() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+// wraps a value so that it owns a full cache line
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) CachePadded {
+    T value;
+
+    CachePadded() = default;
+
+    template <typename... Args>
+    explicit CachePadded(Args&&... args):
+        value(std::forward<Args>(args)...)
+    {}
+
+    T& operator*() { return value; }
+    const T& operator*() const { return value; }
+    T* operator->() { return &value; }
+    const T* operator->() const { return &value; }
+};
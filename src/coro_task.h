@@ -0,0 +1,313 @@
+// src/coro_task.h
+#pragma once
+
+#if __cplusplus < 202002L
+#error "coro_task.h needs C++20 (configure with -DTASK_SCHEDULER_COROUTINES=ON)"
+#endif
+
+#include "task.h"
+#include "task_group.h"
+#include "task_pool.h"
+#include "thread_pool.h"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// Coroutine tasks on top of ThreadPool.
+// A scheduler_task<T> starts when it is awaited (or handed to CoroutineRuntime::run).
+// co_await on one child runs it on the same worker: the parent suspends and
+// transfers to the child, whose final_suspend transfers back to the parent
+// (symmetric transfer, so nested awaits do not grow the stack; GCC emits it as a
+// tail call only with -foptimize-sibling-calls, which -O2 turns on).
+// co_await whenAll(children...) forks: the children run on the pool, each
+// finished child completes a Task that the parent's join Task depends on, and
+// the dependency counting in Task dispatches the join on the worker that
+// finished the last child, which then resumes the parent.
+// No worker ever blocks on a child.
+
+class CoroutineRuntime;
+
+template <typename T>
+class scheduler_task;
+
+// co_await result of a child; void children yield std::monostate
+template <typename T>
+using AwaitResult = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// state shared by every scheduler_task promise
+struct SchedulerPromiseBase {
+    CoroutineRuntime* runtime = nullptr;
+    std::coroutine_handle<> self;
+    std::coroutine_handle<> continuation; // awaited alone: transferred to when we finish
+    Task* done = nullptr;                 // forked: completed when we finish, releases the join
+    std::exception_ptr exception;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            SchedulerPromiseBase& promise = handle.promise();
+            if (Task* done = promise.done) {
+                // the parent may resume and destroy this frame from here on
+                done->execute();
+                return std::noop_coroutine();
+            }
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+    void unhandled_exception() {
+        exception = std::current_exception();
+    }
+
+    void rethrowIfFailed() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+template <typename T>
+struct SchedulerPromise : SchedulerPromiseBase {
+    std::optional<T> value;
+
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+    T takeResult() {
+        rethrowIfFailed();
+        return std::move(*value);
+    }
+};
+
+template <>
+struct SchedulerPromise<void> : SchedulerPromiseBase {
+    void return_void() {}
+    std::monostate takeResult() {
+        rethrowIfFailed();
+        return {};
+    }
+};
+
+// Runs scheduler_tasks on the workers of a ThreadPool. Start and join Tasks come
+// from a TaskPool and are recycled once they finished.
+class CoroutineRuntime : private TaskListener {
+private:
+    ThreadPool& pool_;
+    TaskPool tasks_;
+    TaskGroup outstanding_; // runtime Tasks not recycled yet, a worker may still be inside one
+
+    Task* createTask(TaskWork work) {
+        outstanding_.add();
+        return tasks_.create(pool_.currentWorker(), 0, std::move(work));
+    }
+
+    void onTaskReady(Task* task) override {
+        pool_.submit(task);
+    }
+
+    void onTaskFinished(Task* task) override {
+        TaskGroup* group = task->getGroup();
+        tasks_.destroy(pool_.currentWorker(), task);
+        if (group) {
+            group->done();
+        }
+        outstanding_.done();
+    }
+
+    // Task that is completed by hand (not by the pool) when a coroutine finished
+    Task* createDone(TaskGroup* group) {
+        Task* done = createTask([]() {});
+        done->setGroup(group);
+        done->attachListener(this); // recycled after it ran, never dispatched
+        return done;
+    }
+
+public:
+    // disable copying
+    CoroutineRuntime(const CoroutineRuntime&) = delete;
+    CoroutineRuntime& operator=(const CoroutineRuntime&) = delete;
+
+    // Constructor
+    explicit CoroutineRuntime(ThreadPool& pool):
+        pool_(pool),
+        tasks_(pool.getNumThreads())
+    {}
+
+    // Destructor (waits until the workers left every runtime Task)
+    ~CoroutineRuntime() {
+        outstanding_.wait();
+    }
+
+    // resumes handle on a worker
+    void schedule(std::coroutine_handle<> handle) {
+        Task* start = createTask([handle]() { handle.resume(); });
+        start->setListener(this);
+    }
+
+    // Wires children[0..count) to a join Task that resumes parent, starts all but the
+    // last child on the pool and returns the last one for the caller to run.
+    std::coroutine_handle<> fork(std::coroutine_handle<> parent, SchedulerPromiseBase* const* children, size_t count) {
+        Task* join = createTask([parent]() { parent.resume(); });
+        for (size_t i = 0; i < count; ++i) {
+            children[i]->runtime = this;
+            children[i]->done = createDone(nullptr);
+            join->addDependency(children[i]->done);
+        }
+        join->setListener(this);
+        for (size_t i = 0; i + 1 < count; ++i) {
+            schedule(children[i]->self);
+        }
+        return children[count - 1]->self;
+    }
+
+    // Runs task to completion and returns its result. Blocks the caller, so call it
+    // from outside the pool; inside a scheduler_task use co_await instead.
+    template <typename T>
+    T run(scheduler_task<T> task) {
+        TaskGroup finished;
+        finished.add();
+        auto& promise = task.handle_.promise();
+        promise.runtime = this;
+        promise.done = createDone(&finished);
+        schedule(task.handle_);
+        finished.wait();
+        if constexpr (std::is_void_v<T>) {
+            promise.takeResult();
+        } else {
+            return promise.takeResult();
+        }
+    }
+};
+
+template <typename T = void>
+class scheduler_task {
+public:
+    struct promise_type : SchedulerPromise<T> {
+        scheduler_task get_return_object() {
+            auto handle = std::coroutine_handle<promise_type>::from_promise(*this);
+            this->self = handle;
+            return scheduler_task(handle);
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit scheduler_task(std::coroutine_handle<promise_type> handle):
+        handle_(handle)
+    {}
+
+    friend class CoroutineRuntime;
+    template <typename... Ts>
+    friend class WhenAll;
+
+    struct Awaiter {
+        std::coroutine_handle<promise_type> child;
+
+        bool await_ready() noexcept {
+            return false;
+        }
+        // transfers to the child on this worker; its final_suspend transfers back to the parent
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent) noexcept {
+            child.promise().runtime = parent.promise().runtime;
+            child.promise().continuation = parent;
+            return child;
+        }
+        T await_resume() {
+            if constexpr (std::is_void_v<T>) {
+                child.promise().takeResult();
+            } else {
+                return child.promise().takeResult();
+            }
+        }
+    };
+
+public:
+    // move-only, owns the coroutine frame
+    scheduler_task(const scheduler_task&) = delete;
+    scheduler_task& operator=(const scheduler_task&) = delete;
+
+    scheduler_task(scheduler_task&& other) noexcept:
+        handle_(std::exchange(other.handle_, nullptr))
+    {}
+
+    scheduler_task& operator=(scheduler_task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    // Destructor
+    ~scheduler_task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // runs the child on this worker, the awaiting coroutine continues when it finished
+    Awaiter operator co_await() && noexcept {
+        return Awaiter{handle_};
+    }
+};
+
+// co_await whenAll(a, b, ...) runs the children in parallel and yields a tuple of their results
+template <typename... Ts>
+class WhenAll {
+private:
+    std::tuple<scheduler_task<Ts>...> children_;
+
+public:
+    explicit WhenAll(scheduler_task<Ts>... children):
+        children_(std::move(children)...)
+    {}
+
+    bool await_ready() noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent) {
+        SchedulerPromiseBase* promises[sizeof...(Ts)];
+        std::apply([&promises](auto&... children) {
+            size_t i = 0;
+            ((promises[i++] = &children.handle_.promise()), ...);
+        }, children_);
+        return parent.promise().runtime->fork(parent, promises, sizeof...(Ts));
+    }
+
+    std::tuple<AwaitResult<Ts>...> await_resume() {
+        return std::apply([](auto&... children) {
+            return std::tuple<AwaitResult<Ts>...>(children.handle_.promise().takeResult()...);
+        }, children_);
+    }
+};
+
+template <typename... Ts>
+WhenAll<Ts...> whenAll(scheduler_task<Ts>... children) {
+    static_assert(sizeof...(Ts) > 0, "whenAll needs at least one child");
+    return WhenAll<Ts...>(std::move(children)...);
+}
@@ -0,0 +1,121 @@
+// src/critical_path.h
+#pragma once
+
+#include "task.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+enum class SchedulingPolicy {
+    FIFO,           // ready tasks go to the pool in the order they became ready
+    CRITICAL_PATH   // ready tasks of a priority class are dispatched by upward rank, longest remaining path first
+};
+
+// Upward rank as in HEFT (Topcuoglu et al.): rank(t) = cost(t) + max rank of
+// t's successors, i.e. the length of the longest path from t to an exit task.
+// tasks must hold the whole graph before any of it is submitted; edges leaving
+// the set are ignored. cost(const Task&) may return measured run times instead
+// of the estimates set with Task::setCost().
+template <typename CostFn>
+void computeUpwardRanks(const std::vector<Task*>& tasks, CostFn&& cost) {
+    std::unordered_map<const Task*, size_t> index;
+    index.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        index.emplace(tasks[i], i);
+    }
+
+    // topological order over the successor edges (Kahn)
+    std::vector<size_t> in_degree(tasks.size(), 0);
+    for (const Task* task : tasks) {
+        task->forEachSuccessor([&](Task* successor) {
+            auto it = index.find(successor);
+            if (it != index.end()) {
+                ++in_degree[it->second];
+            }
+        });
+    }
+    std::vector<Task*> order;
+    order.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (in_degree[i] == 0) {
+            order.push_back(tasks[i]);
+        }
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+        order[head]->forEachSuccessor([&](Task* successor) {
+            auto it = index.find(successor);
+            if (it != index.end() && --in_degree[it->second] == 0) {
+                order.push_back(successor);
+            }
+        });
+    }
+
+    // exit tasks first, every successor is ranked before its predecessors
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        Task* task = *it;
+        double longest = 0.0;
+        task->forEachSuccessor([&](Task* successor) {
+            if (index.count(successor)) {
+                longest = std::max(longest, successor->getRank());
+            }
+        });
+        task->setRank(static_cast<double>(cost(*task)) + longest);
+    }
+}
+
+inline void computeUpwardRanks(const std::vector<Task*>& tasks) {
+    computeUpwardRanks(tasks, [](const Task& task) { return task.getCost(); });
+}
+
+// Ready tasks ordered by rank, highest first (equal ranks in the order they became ready).
+class RankedReadyQueue {
+private:
+    struct Entry {
+        double rank;
+        uint64_t sequence;
+        Task* task;
+    };
+
+    struct Lower {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.rank < b.rank || (a.rank == b.rank && a.sequence > b.sequence);
+        }
+    };
+
+    std::mutex mutex_;
+    std::priority_queue<Entry, std::vector<Entry>, Lower> heap_;
+    uint64_t next_sequence_ = 0;
+
+public:
+    // disable copying
+    RankedReadyQueue(const RankedReadyQueue&) = delete;
+    RankedReadyQueue& operator=(const RankedReadyQueue&) = delete;
+
+    // Constructor
+    RankedReadyQueue() = default;
+
+    void push(Task* task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        heap_.push(Entry{task->getRank(), next_sequence_++, task});
+    }
+
+    // highest ranked task, nullptr if empty
+    Task* pop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (heap_.empty()) {
+            return nullptr;
+        }
+        Task* task = heap_.top().task;
+        heap_.pop();
+        return task;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
+    }
+};
@@ -0,0 +1,307 @@
+// src/graph_snapshot.h
+#pragma once
+
+#include "kernel_registry.h"
+#include "task_graph.h"
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary form of a frozen TaskGraph of kernel nodes, laid out so that a mapped file is used
+// as is (native byte order, every section 8-byte aligned):
+//   SnapshotHeader
+//   SnapshotNode nodes[num_nodes]        kernel id, in-degree, parameter blob, rank
+//   uint32_t offsets[num_nodes + 1]      CSR: successors of node i are
+//   uint32_t successors[num_edges]       successors[offsets[i] .. offsets[i + 1])
+//   uint32_t roots[num_roots]            nodes without dependencies
+//   unsigned char params[param_bytes]    parameter blobs
+// Loading checks the header, the section bounds and, in one linear pass, that the sections
+// hold a DAG run() can walk (indices in range, in-degrees and roots consistent, no cycle);
+// nothing is built per node.
+
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = {'T', 'S', 'G', 'R', 'A', 'P', 'H', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t node_size; // sizeof(SnapshotNode) of the writer
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t num_roots;
+    uint64_t param_bytes;
+    uint64_t file_size;
+};
+
+struct SnapshotNode {
+    uint32_t kernel;
+    uint32_t in_degree;
+    uint32_t param_size;
+    int32_t priority; // TaskPriority
+    uint64_t param_offset;
+    double rank;      // upward rank for SchedulingPolicy::CRITICAL_PATH
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotNode) % 8 == 0,
+              "snapshot sections must stay 8-byte aligned");
+
+// A graph snapshot mapped read-only into memory; run it with TaskScheduler::run(snapshot, registry).
+// open() rejects any file whose data would make a run read out of bounds, run a node twice or
+// never finish, so a corrupted file is refused instead of trusted.
+class GraphSnapshot {
+private:
+    void* data_ = MAP_FAILED;
+    size_t size_ = 0;
+    const SnapshotHeader* header_ = nullptr;
+    const SnapshotNode* nodes_ = nullptr;
+    const uint32_t* offsets_ = nullptr;
+    const uint32_t* successors_ = nullptr;
+    const uint32_t* roots_ = nullptr;
+    const unsigned char* params_ = nullptr;
+
+    static size_t aligned(size_t bytes) {
+        return (bytes + 7) & ~size_t(7);
+    }
+
+    // section offsets for the counts of a header (in file order), returns the file size
+    // (SIZE_MAX for counts no snapshot can have, so that no file matches them)
+    static size_t layout(const SnapshotHeader& header, size_t (&sections)[5]) {
+        // bounded counts: the sizes below cannot overflow
+        if (header.num_nodes >= UINT32_MAX || header.num_edges > UINT32_MAX ||
+            header.num_roots > header.num_nodes || header.param_bytes > SIZE_MAX / 2) {
+            return SIZE_MAX;
+        }
+        size_t offset = sizeof(SnapshotHeader);
+        size_t sizes[5] = {
+            header.num_nodes * sizeof(SnapshotNode),
+            (header.num_nodes + 1) * sizeof(uint32_t),
+            header.num_edges * sizeof(uint32_t),
+            header.num_roots * sizeof(uint32_t),
+            header.param_bytes,
+        };
+        for (size_t i = 0; i < 5; ++i) {
+            sections[i] = offset;
+            offset += aligned(sizes[i]);
+        }
+        return offset;
+    }
+
+    // One pass over the mapped sections: CSR offsets ascending, successor and root ids below
+    // num_nodes, parameter blobs inside the params section, priorities valid, every in-degree
+    // equal to the node's number of predecessors, the roots exactly the nodes without any,
+    // and every node reachable from them in topological order (no cycle).
+    static bool validate(const SnapshotHeader& header, const SnapshotNode* nodes, const uint32_t* offsets,
+                         const uint32_t* successors, const uint32_t* roots) {
+        size_t n = header.num_nodes;
+        if (offsets[0] != 0) {
+            return false;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const SnapshotNode& node = nodes[i];
+            if (offsets[i] > offsets[i + 1] || node.priority < 0 || size_t(node.priority) >= NUM_PRIORITIES ||
+                node.param_offset > header.param_bytes || node.param_size > header.param_bytes - node.param_offset) {
+                return false;
+            }
+        }
+        std::vector<uint32_t> remaining(n, 0);
+        for (size_t e = 0; e < header.num_edges; ++e) {
+            if (successors[e] >= n) {
+                return false;
+            }
+            ++remaining[successors[e]];
+        }
+        size_t num_sources = 0;
+        for (size_t i = 0; i < n; ++i) {
+            // the top bit of a run's release counters marks skipped nodes
+            if (nodes[i].in_degree != remaining[i] || nodes[i].in_degree > INT32_MAX) {
+                return false;
+            }
+            num_sources += nodes[i].in_degree == 0;
+        }
+        if (num_sources != header.num_roots) {
+            return false;
+        }
+        std::vector<uint32_t> order(roots, roots + header.num_roots);
+        std::vector<bool> listed(n, false);
+        for (uint32_t root : order) {
+            if (root >= n || nodes[root].in_degree != 0 || listed[root]) {
+                return false;
+            }
+            listed[root] = true;
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (uint32_t e = offsets[order[i]]; e < offsets[order[i] + 1]; ++e) {
+                if (--remaining[successors[e]] == 0) {
+                    order.push_back(successors[e]);
+                }
+            }
+        }
+        return order.size() == n;
+    }
+
+    void unmap() {
+        if (data_ != MAP_FAILED) {
+            munmap(data_, size_);
+        }
+        data_ = MAP_FAILED;
+        size_ = 0;
+        header_ = nullptr;
+    }
+
+public:
+    // disable copying
+    GraphSnapshot(const GraphSnapshot&) = delete;
+    GraphSnapshot& operator=(const GraphSnapshot&) = delete;
+
+    // Constructor
+    GraphSnapshot() = default;
+
+    // Destructor (unmaps the file; do not destroy it while a run is in progress)
+    ~GraphSnapshot() {
+        unmap();
+    }
+
+    // Getters
+    bool isOpen() const {
+        return header_ != nullptr;
+    }
+    size_t size() const {
+        return header_ ? header_->num_nodes : 0;
+    }
+    size_t numEdges() const {
+        return header_ ? header_->num_edges : 0;
+    }
+    size_t numRoots() const {
+        return header_ ? header_->num_roots : 0;
+    }
+    const SnapshotNode& node(size_t node) const {
+        return nodes_[node];
+    }
+    const uint32_t* successorsBegin(size_t node) const {
+        return successors_ + offsets_[node];
+    }
+    const uint32_t* successorsEnd(size_t node) const {
+        return successors_ + offsets_[node + 1];
+    }
+    const uint32_t* roots() const {
+        return roots_;
+    }
+    KernelParams params(uint32_t node) const {
+        return KernelParams{params_ + nodes_[node].param_offset, nodes_[node].param_size, node};
+    }
+
+    // Maps path (replacing what was open). False if it cannot be mapped, is not a
+    // snapshot of this version, its counts do not fit its sections, or the sections
+    // fail validate().
+    bool open(const std::string& path) {
+        unmap();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_ = size_t(info.st_size);
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file
+        if (data_ == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+
+        const SnapshotHeader* header = static_cast<const SnapshotHeader*>(data_);
+        size_t sections[5];
+        if (std::memcmp(header->magic, SnapshotHeader::MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != SnapshotHeader::VERSION || header->node_size != sizeof(SnapshotNode) ||
+            header->file_size != size_ || layout(*header, sections) != size_ ||
+            (header->num_roots == 0 && header->num_nodes > 0)) { // a run would never finish
+            unmap();
+            return false;
+        }
+        const unsigned char* base = static_cast<const unsigned char*>(data_);
+        const SnapshotNode* nodes = reinterpret_cast<const SnapshotNode*>(base + sections[0]);
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(base + sections[1]);
+        const uint32_t* successors = reinterpret_cast<const uint32_t*>(base + sections[2]);
+        const uint32_t* roots = reinterpret_cast<const uint32_t*>(base + sections[3]);
+        if (offsets[header->num_nodes] != header->num_edges ||
+            !validate(*header, nodes, offsets, successors, roots)) {
+            unmap();
+            return false;
+        }
+        header_ = header;
+        nodes_ = nodes;
+        offsets_ = offsets;
+        successors_ = successors;
+        roots_ = roots;
+        params_ = base + sections[4];
+        return true;
+    }
+
+    // Writes graph (frozen here if needed) to path. False if the graph has a cycle, has a
+    // node that is not a kernel node, or the file cannot be written.
+    static bool write(TaskGraph& graph, const std::string& path) {
+        if (!graph.freeze()) {
+            return false;
+        }
+        size_t n = graph.size();
+        SnapshotHeader header;
+        std::memcpy(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic));
+        header.version = SnapshotHeader::VERSION;
+        header.node_size = sizeof(SnapshotNode);
+        header.num_nodes = n;
+        header.num_edges = graph.successors_.size();
+        header.param_bytes = graph.params_.size();
+
+        std::vector<SnapshotNode> nodes(n);
+        std::vector<uint32_t> roots;
+        for (size_t i = 0; i < n; ++i) {
+            const KernelCall& call = graph.kernel_calls_[i];
+            if (call.kernel == KernelCall::NONE) {
+                return false;
+            }
+            SnapshotNode& node = nodes[i];
+            node.kernel = call.kernel;
+            node.in_degree = static_cast<uint32_t>(graph.in_degree_[i]);
+            node.param_size = call.param_size;
+            node.priority = static_cast<int32_t>(graph.tasks_[i]->getPriority());
+            node.param_offset = call.param_offset;
+            node.rank = graph.tasks_[i]->getRank();
+            if (node.in_degree == 0) {
+                roots.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        header.num_roots = roots.size();
+        size_t sections[5];
+        header.file_size = layout(header, sections);
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        auto section = [&out](size_t offset, const void* data, size_t bytes) {
+            static const char padding[8] = {};
+            out.write(padding, std::streamsize(offset - size_t(out.tellp())));
+            out.write(static_cast<const char*>(data), std::streamsize(bytes));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        section(sections[0], nodes.data(), nodes.size() * sizeof(SnapshotNode));
+        section(sections[1], graph.offsets_.data(), graph.offsets_.size() * sizeof(uint32_t));
+        section(sections[2], graph.successors_.data(), graph.successors_.size() * sizeof(uint32_t));
+        section(sections[3], roots.data(), roots.size() * sizeof(uint32_t));
+        section(sections[4], graph.params_.data(), graph.params_.size());
+        section(header.file_size, nullptr, 0);
+        return bool(out.flush());
+    }
+};
@@ -0,0 +1,146 @@
+// src/inline_function.h
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 48>
+class InlineFunction;
+
+template <typename T>
+struct IsStdFunction : std::false_type {};
+template <typename Signature>
+struct IsStdFunction<std::function<Signature>> : std::true_type {};
+
+// Move-only replacement for std::function.
+// Callables up to Capacity bytes are stored inline (no allocation), larger
+// ones fall back to the heap. Dispatch goes through one static table per type.
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*relocate)(void* dst, void* src) noexcept; // move into dst and destroy src
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename F>
+    static constexpr bool fits_inline =
+        sizeof(F) <= Capacity &&
+        alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<F>;
+
+    // callable lives in storage_
+    template <typename F>
+    struct InlineOps {
+        static R invoke(void* storage, Args&&... args) {
+            return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+        }
+        static void relocate(void* dst, void* src) noexcept {
+            new (dst) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+        static void destroy(void* storage) noexcept {
+            static_cast<F*>(storage)->~F();
+        }
+        static constexpr Ops table{&invoke, &relocate, &destroy};
+    };
+
+    // storage_ holds a pointer to a heap-allocated callable
+    template <typename F>
+    struct HeapOps {
+        static F* get(void* storage) {
+            return *static_cast<F**>(storage);
+        }
+        static R invoke(void* storage, Args&&... args) {
+            return (*get(storage))(std::forward<Args>(args)...);
+        }
+        static void relocate(void* dst, void* src) noexcept {
+            new (dst) F*(get(src));
+        }
+        static void destroy(void* storage) noexcept {
+            delete get(storage);
+        }
+        static constexpr Ops table{&invoke, &relocate, &destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops* ops_ = nullptr;
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+public:
+    static_assert(Capacity >= sizeof(void*), "capacity must at least hold the heap fallback pointer");
+
+    InlineFunction() = default;
+    InlineFunction(std::nullptr_t) {}
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, InlineFunction> &&
+                                          std::is_invocable_r_v<R, Fn&, Args...>>>
+    InlineFunction(F&& f) {
+        // a null function pointer or an empty std::function makes an empty InlineFunction
+        if constexpr (std::is_pointer_v<Fn> || std::is_member_pointer_v<Fn> || IsStdFunction<Fn>::value) {
+            if (!f) {
+                return;
+            }
+        }
+        if constexpr (fits_inline<Fn>) {
+            new (storage_) Fn(std::forward<F>(f));
+            ops_ = &InlineOps<Fn>::table;
+        } else {
+            new (storage_) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &HeapOps<Fn>::table;
+        }
+    }
+
+    // move-only
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    InlineFunction(InlineFunction&& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops_) {
+                other.ops_->relocate(storage_, other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    // Destructor
+    ~InlineFunction() {
+        reset();
+    }
+
+    explicit operator bool() const {
+        return ops_ != nullptr;
+    }
+
+    // throws std::bad_function_call if empty (like std::function; a Task turns it into FAILED)
+    R operator()(Args... args) {
+        if (!ops_) {
+            throw std::bad_function_call();
+        }
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+};
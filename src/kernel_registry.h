@@ -0,0 +1,83 @@
+// src/kernel_registry.h
+#pragma once
+
+#include "inline_function.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// what a kernel gets for one node: its parameter blob (copied into the graph, or
+// pointing into a mapped snapshot) and the node index
+struct KernelParams {
+    const void* data;
+    size_t size;
+    uint32_t node;
+
+    // the blob as a trivially copyable T (written with sizeof(T) bytes). Copied out, since
+    // blobs are packed back to back and need not be aligned for T; throws
+    // std::invalid_argument if the blob has another size (fails the node)
+    template <typename T>
+    T as() const {
+        static_assert(std::is_trivially_copyable_v<T>, "kernel parameters are copied as raw bytes");
+        if (size != sizeof(T)) {
+            throw std::invalid_argument("parameters of node " + std::to_string(node) + " are " +
+                                        std::to_string(size) + " bytes, not " + std::to_string(sizeof(T)));
+        }
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+};
+
+using Kernel = InlineFunction<void(const KernelParams&)>;
+
+// kernel of a node and where its parameters are in the graph's blob
+struct KernelCall {
+    static constexpr uint32_t NONE = UINT32_MAX; // node built from plain TaskWork
+
+    uint32_t kernel = NONE;
+    uint32_t param_size = 0;
+    uint64_t param_offset = 0;
+};
+
+// Callables by kernel id. A graph (TaskGraph::addNode(registry, kernel, ...) or a loaded
+// GraphSnapshot) only stores ids, so it can be saved and bound to the callables again in
+// another process. Register everything before running; kernels run concurrently.
+class KernelRegistry {
+private:
+    std::vector<Kernel> kernels_;
+
+public:
+    // disable copying
+    KernelRegistry(const KernelRegistry&) = delete;
+    KernelRegistry& operator=(const KernelRegistry&) = delete;
+
+    // Constructor
+    KernelRegistry() = default;
+
+    // Getter
+    bool contains(uint32_t id) const {
+        return id < kernels_.size() && kernels_[id];
+    }
+
+    // registers (or replaces) kernel id
+    void add(uint32_t id, Kernel kernel) {
+        if (id >= kernels_.size()) {
+            kernels_.resize(id + 1);
+        }
+        kernels_[id] = std::move(kernel);
+    }
+
+    // runs kernel id; throws std::out_of_range if it was never registered (fails the node)
+    void call(uint32_t id, const KernelParams& params) {
+        if (!contains(id)) {
+            throw std::out_of_range("kernel " + std::to_string(id) + " is not registered");
+        }
+        kernels_[id](params);
+    }
+};
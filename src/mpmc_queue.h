@@ -0,0 +1,135 @@
+// src/mpmc_queue.h
+#pragma once
+
+#include "cache_line.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free MPMC queue (D. Vyukov's array queue): every slot carries a
+// sequence number that says whether it is free for the producer of a position or
+// filled for its consumer. Producers and consumers claim positions with one CAS on
+// their own index, so neither side takes a lock. FIFO; push fails when the queue is full,
+// pushBulk claims a run of positions for a whole batch with a single CAS.
+template <typename T>
+class MpmcQueue {
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T* item;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    uint64_t mask_;
+    // producers and consumers each hammer their own index
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0};
+
+public:
+    // disable copying
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Constructor (capacity is rounded up to a power of two)
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = size - 1;
+    }
+
+    // Getters
+    size_t capacity() const {
+        return static_cast<size_t>(mask_ + 1);
+    }
+    // approximate while other threads push or pop
+    size_t size() const {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    // any thread; false if the queue is full
+    bool push(T* item) {
+        uint64_t position = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence - position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // any thread; pushes the longest prefix of items[0..count) that fits, claiming its
+    // positions with one CAS, and returns its length (0 if the queue is full)
+    size_t pushBulk(T* const* items, size_t count) {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t position = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            // a free cell keeps its sequence until the producer that claims it moved tail_
+            size_t claimed = 0;
+            while (claimed < count && claimed <= mask_) {
+                uint64_t sequence = cells_[(position + claimed) & mask_].sequence.load(std::memory_order_acquire);
+                if (sequence != position + claimed) {
+                    break;
+                }
+                ++claimed;
+            }
+            if (claimed == 0) {
+                uint64_t sequence = cells_[position & mask_].sequence.load(std::memory_order_acquire);
+                if (static_cast<int64_t>(sequence - position) < 0) {
+                    return 0;
+                }
+                position = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (tail_.compare_exchange_weak(position, position + claimed, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < claimed; ++i) {
+                    Cell& cell = cells_[(position + i) & mask_];
+                    cell.item = items[i];
+                    cell.sequence.store(position + i + 1, std::memory_order_release);
+                }
+                return claimed;
+            }
+        }
+    }
+
+    // any thread; nullptr if the queue is empty
+    T* pop() {
+        uint64_t position = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence - (position + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    T* item = cell.item;
+                    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return item;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
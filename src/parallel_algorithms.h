@@ -0,0 +1,176 @@
+// src/parallel_algorithms.h
+#pragma once
+
+#include "cache_line.h"
+#include "task_group.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Loop primitives on top of TaskScheduler. They block the caller until the loop is
+// done, so call them from outside the pool (not from inside a task). If the body
+// throws, the loop stops early and rethrows the first exception to the caller.
+//
+// Ranges are split lazily (lazy binary splitting, Tzannes et al., PPoPP'10): a task
+// works through its range grain indices at a time, and whenever the queue of its
+// worker ran dry it splits off the upper half of what is left as a new task for
+// idle workers to steal. Busy machines therefore create few tasks, idle workers
+// still find work quickly, and grain only bounds the per-check overhead.
+
+// default grain: enough steps per worker that splitting can balance the load
+inline size_t defaultGrain(const TaskScheduler& scheduler, size_t count) {
+    return std::max<size_t>(1, count / (scheduler.getNumThreads() * 256));
+}
+
+// one running loop: its tasks, and the first exception a chunk threw
+struct ParallelLoop {
+    TaskGroup group;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error; // written by the first failing chunk, read after group.wait()
+
+    void fail() {
+        if (!failed.exchange(true, std::memory_order_relaxed)) {
+            error = std::current_exception();
+        }
+    }
+};
+
+// processes [begin, end) with chunk(lo, hi), splitting as described above; once a
+// chunk threw, the loop neither splits nor runs further chunks
+template <typename Chunk>
+void lazySplit(TaskScheduler& scheduler, ParallelLoop& loop, size_t begin, size_t end, size_t grain, const Chunk& chunk) {
+    try {
+        while (end - begin > grain) {
+            if (loop.failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if (scheduler.localBacklog() == 0) {
+                size_t middle = begin + (end - begin) / 2;
+                scheduler.submit([&scheduler, &loop, middle, end, grain, &chunk]() {
+                    lazySplit(scheduler, loop, middle, end, grain, chunk);
+                }, loop.group);
+                end = middle;
+                continue;
+            }
+            chunk(begin, begin + grain);
+            begin += grain;
+        }
+        if (!loop.failed.load(std::memory_order_relaxed)) {
+            chunk(begin, end);
+        }
+    } catch (...) {
+        // kept by the loop (not the scheduler's errors), parallelChunks rethrows it
+        loop.fail();
+    }
+}
+
+// Runs chunk(lo, hi) over disjoint sub-ranges covering [begin, end) and waits.
+// If a chunk throws, the rest of the range is skipped and the first exception is
+// rethrown here once every task of the loop has finished.
+template <typename Chunk>
+void parallelChunks(TaskScheduler& scheduler, size_t begin, size_t end, size_t grain, const Chunk& chunk) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain == 0) {
+        grain = defaultGrain(scheduler, end - begin);
+    }
+    ParallelLoop loop;
+    scheduler.submit([&scheduler, &loop, begin, end, grain, &chunk]() {
+        lazySplit(scheduler, loop, begin, end, grain, chunk);
+    }, loop.group);
+    loop.group.wait();
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+// body(i) for every i in [begin, end), or body(lo, hi) per sub-range
+template <typename Body>
+void parallel_for(TaskScheduler& scheduler, size_t begin, size_t end, const Body& body, size_t grain = 0) {
+    if constexpr (std::is_invocable_v<const Body&, size_t, size_t>) {
+        parallelChunks(scheduler, begin, end, grain, body);
+    } else {
+        parallelChunks(scheduler, begin, end, grain, [&body](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                body(i);
+            }
+        });
+    }
+}
+
+// Folds [begin, end): every worker accumulates into its own padded slot with
+// acc = range(lo, hi, acc), the slots are combined at the end (no atomics).
+// combine must be associative and commutative, identity its neutral element.
+template <typename T, typename Range, typename Combine>
+T parallel_reduce(TaskScheduler& scheduler, size_t begin, size_t end, T identity,
+                  const Range& range, const Combine& combine, size_t grain = 0) {
+    // slot 0 for the caller, 1 + i for worker i
+    std::vector<CachePadded<T>> partials(scheduler.getNumThreads() + 1, CachePadded<T>(identity));
+    parallelChunks(scheduler, begin, end, grain, [&](size_t lo, size_t hi) {
+        T& acc = partials[scheduler.currentWorker() + 1].value;
+        acc = range(lo, hi, std::move(acc));
+    });
+
+    T result = std::move(identity);
+    for (auto& partial : partials) {
+        result = combine(std::move(result), std::move(partial.value));
+    }
+    return result;
+}
+
+// Inclusive scan: out[i] = in[0] op ... op in[i] (out may equal in).
+// Two passes, both split lazily: the first folds the chunks it happens to run into
+// per-worker lists of (lo, hi, total), a serial scan over those totals (sorted by lo)
+// gives every chunk its offset, and the second pass scans the recorded chunks from
+// their offsets, again split over the chunk list. combine must be associative.
+template <typename T, typename Combine>
+void parallel_scan(TaskScheduler& scheduler, const T* in, T* out, size_t count, T identity,
+                   const Combine& combine, size_t grain = 0) {
+    if (count == 0) {
+        return;
+    }
+    struct Block {
+        size_t lo;
+        size_t hi;
+        T total; // of the block, then the exclusive offset before it
+    };
+    // slot 0 for the caller, 1 + i for worker i
+    std::vector<CachePadded<std::vector<Block>>> recorded(scheduler.getNumThreads() + 1);
+    parallelChunks(scheduler, 0, count, grain, [&](size_t lo, size_t hi) {
+        T sum = identity;
+        for (size_t i = lo; i < hi; ++i) {
+            sum = combine(sum, in[i]);
+        }
+        recorded[scheduler.currentWorker() + 1].value.push_back(Block{lo, hi, std::move(sum)});
+    });
+
+    std::vector<Block> blocks;
+    for (auto& list : recorded) {
+        blocks.insert(blocks.end(), std::make_move_iterator(list.value.begin()),
+                      std::make_move_iterator(list.value.end()));
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.lo < b.lo; });
+    // exclusive offsets of the blocks
+    T running = identity;
+    for (Block& block : blocks) {
+        T block_total = std::move(block.total);
+        block.total = running;
+        running = combine(running, block_total);
+    }
+
+    parallel_for(scheduler, 0, blocks.size(), [&](size_t index) {
+        const Block& block = blocks[index];
+        T sum = block.total;
+        for (size_t i = block.lo; i < block.hi; ++i) {
+            sum = combine(sum, in[i]);
+            out[i] = sum;
+        }
+    });
+}
@@ -0,0 +1,213 @@
+// src/scheduler_stats.h
+#pragma once
+
+#include "cache_line.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Instrumentation can be compiled out (-DTASK_SCHEDULER_STATS=0); when compiled in,
+// it is still off until enabled at runtime (ThreadPoolOptions::collect_stats).
+#ifndef TASK_SCHEDULER_STATS
+#define TASK_SCHEDULER_STATS 1
+#endif
+
+// nanoseconds on the steady clock
+inline uint64_t statsClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// adds to a counter that only one thread writes (no locked instruction);
+// shared counters (written by several threads) need the atomic add
+inline void bumpCounter(std::atomic<uint64_t>& counter, uint64_t amount, bool shared) {
+    if (shared) {
+        counter.fetch_add(amount, std::memory_order_relaxed);
+    } else {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+}
+
+// HDR-style log-linear histogram: 16 linear sub-buckets per power of two, so every
+// recorded value is known to within 1/16 (about 6%). Covers 0 .. 2^40 (18 minutes in ns),
+// larger values land in the last bucket. Readers may copy it while a writer records.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BITS = 4;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BITS;
+    static constexpr uint32_t MAX_EXPONENT = 40;
+    static constexpr size_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS;
+
+private:
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+        if (exponent > MAX_EXPONENT) {
+            return NUM_BUCKETS - 1;
+        }
+        uint64_t sub = (value >> (exponent - SUB_BITS)) - SUB_BUCKETS;
+        return (exponent - SUB_BITS + 1) * SUB_BUCKETS + static_cast<size_t>(sub);
+    }
+
+    // largest value that falls into bucket
+    static uint64_t bucketLimit(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        uint32_t exponent = static_cast<uint32_t>(bucket / SUB_BUCKETS) + SUB_BITS - 1;
+        uint64_t sub = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+
+public:
+    // Constructor
+    LatencyHistogram() = default;
+
+    // copies are snapshots
+    LatencyHistogram(const LatencyHistogram& other) {
+        add(other);
+    }
+    LatencyHistogram& operator=(const LatencyHistogram& other) {
+        if (this != &other) {
+            clear();
+            add(other);
+        }
+        return *this;
+    }
+
+    // Getters
+    uint64_t count() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+    uint64_t max() const {
+        return max_.load(std::memory_order_relaxed);
+    }
+    double mean() const {
+        uint64_t n = count();
+        return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / n;
+    }
+
+    // records one value (shared: more than one thread records into this histogram)
+    void record(uint64_t value, bool shared = false) {
+        bumpCounter(buckets_[bucketOf(value)], 1, shared);
+        bumpCounter(count_, 1, shared);
+        bumpCounter(sum_, value, shared);
+        uint64_t current = max_.load(std::memory_order_relaxed);
+        while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // merges other into this histogram (this one must not be recorded into meanwhile)
+    void add(const LatencyHistogram& other) {
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+            if (n > 0) {
+                bumpCounter(buckets_[i], n, false);
+            }
+        }
+        bumpCounter(count_, other.count(), false);
+        bumpCounter(sum_, other.sum_.load(std::memory_order_relaxed), false);
+        max_.store(std::max(max(), other.max()), std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    // value below which a fraction q (0..1) of the recorded values lie (upper bucket bound)
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * n)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(bucketLimit(i), max());
+            }
+        }
+        return max();
+    }
+};
+
+// per-worker event counters
+enum class StatCounter : uint8_t {
+    TASKS_EXECUTED,
+    LOCAL_POPS,        // taken from the worker's own deque
+    INJECTED_POPS,     // taken from an injection queue (or the shared queue)
+    STEALS,            // taken from another worker's deque
+    SPIN_HITS,         // work found while spinning, no park needed
+    PARKS,             // waits on the condition variable
+    BUSY_NS,           // time spent running tasks (extrapolated from the timed tasks)
+    IDLE_NS,           // time spent spinning or parked
+    LOCK_ACQUISITIONS, // queue locks taken
+    LOCK_CONTENDED     // ... of which were held by another thread
+};
+constexpr size_t NUM_STAT_COUNTERS = 10;
+
+// Statistics of one worker (or of the threads outside the pool).
+// Each worker writes only its own instance, which is padded to whole cache lines.
+struct alignas(CACHE_LINE_SIZE) WorkerStats {
+    bool shared = false; // recorded into by several threads (the outside-the-pool slot)
+    std::atomic<uint64_t> counters[NUM_STAT_COUNTERS] = {};
+    LatencyHistogram queue_wait; // ready -> started, ns (timed tasks only)
+    LatencyHistogram run_time;   // started -> finished, ns (timed tasks only)
+    LatencyHistogram lock_wait;  // blocked on a contended queue lock, ns
+
+    void add(StatCounter counter, uint64_t amount = 1) {
+        bumpCounter(counters[static_cast<size_t>(counter)], amount, shared);
+    }
+    uint64_t get(StatCounter counter) const {
+        return counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+};
+
+// snapshot of one worker's statistics
+struct WorkerStatsSnapshot {
+    uint64_t counters[NUM_STAT_COUNTERS] = {};
+    LatencyHistogram queue_wait;
+    LatencyHistogram run_time;
+    LatencyHistogram lock_wait;
+
+    uint64_t get(StatCounter counter) const {
+        return counters[static_cast<size_t>(counter)];
+    }
+
+    // adds the live statistics of stats (or of another snapshot)
+    template <typename Stats>
+    void add(const Stats& stats) {
+        for (size_t i = 0; i < NUM_STAT_COUNTERS; ++i) {
+            counters[i] += stats.get(static_cast<StatCounter>(i));
+        }
+        queue_wait.add(stats.queue_wait);
+        run_time.add(stats.run_time);
+        lock_wait.add(stats.lock_wait);
+    }
+};
+
+// Snapshot returned by getStats(): aggregated when it is taken, the workers keep running
+struct SchedulerStats {
+    std::vector<WorkerStatsSnapshot> workers; // one per worker, then one for threads outside the pool
+    WorkerStatsSnapshot total;
+    size_t queued_tasks = 0;     // in all queues when the snapshot was taken
+    size_t sleeping_workers = 0;
+    size_t spinning_workers = 0;
+};
@@ -2,29 +2,228 @@
 
 #pragma once
 
+#include "cache_line.h"
+#include "inline_function.h"
 #include <atomic>
-#include <functional>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <memory>
 #include <vector>
-#include <mutex>
 
-enum class TaskState {
+enum class TaskState : uint8_t {
     PENDING,
     RUNNING,
-    COMPLETED
+    COMPLETED,
+    CANCELLED, // work skipped: cancelled, past its deadline, or a dependency was cancelled
+    FAILED     // work threw, the exception is kept in the task (getError)
 };
 
-class Task {
+// what happens to the dependents of a task whose work threw
+enum class FailurePolicy {
+    SKIP_DEPENDENTS, // they are cancelled, transitively (see Task::cancel)
+    RUN_DEPENDENTS   // they run as if the task had completed
+};
+
+// scheduling class, lower value = served first (starvation is bounded by aging in the pool)
+enum class TaskPriority : uint8_t {
+    HIGH,
+    NORMAL,
+    LOW
+};
+constexpr size_t NUM_PRIORITIES = 3;
+
+class Task;
+class TaskGroup;
+
+// move-only callables, captures up to 48 bytes are stored inside the task
+using TaskWork = InlineFunction<void()>;
+using TaskCallback = InlineFunction<void(Task*)>;
+
+// Cancels every task that holds it (Task::setCancellationToken) and has not started yet.
+// One token typically covers a whole flow; it must outlive the tasks that hold it.
+class CancellationToken {
 private:
-    uint64_t id_;
+    std::atomic<bool> cancelled_{false};
+
+public:
+    // disable copying
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    // Constructor
+    CancellationToken() = default;
+
+    bool isCancelled() const {
+        return cancelled_.load(std::memory_order_acquire);
+    }
+    void cancel() {
+        cancelled_.store(true, std::memory_order_release);
+    }
+    // arms the token again (for tasks submitted afterwards)
+    void reset() {
+        cancelled_.store(false, std::memory_order_release);
+    }
+};
+
+// owner of a submitted task (the scheduler)
+class TaskListener {
+public:
+    // the task's last dependency has been released
+    virtual void onTaskReady(Task* task) = 0;
+    // the task ran and released its dependents; the task must not be touched afterwards
+    virtual void onTaskFinished(Task* task) = 0;
+    // the task's work threw (task->getError()), called before its dependents are released
+    virtual FailurePolicy onTaskFailed(Task* /*task*/) {
+        return FailurePolicy::SKIP_DEPENDENTS;
+    }
+    // the last reference to a finished value task was dropped (see Task::retain)
+    virtual void onTaskReleased(Task* /*task*/) {}
+
+protected:
+    ~TaskListener() = default;
+};
+
+// -DTASK_SCHEDULER_PACKED_TASK=1 packs the Task fields without cache line alignment (as
+// before the dependency counter got its own line), to compare the layouts in benchmarks
+#ifndef TASK_SCHEDULER_PACKED_TASK
+#define TASK_SCHEDULER_PACKED_TASK 0
+#endif
+constexpr size_t TASK_LINE_SIZE = TASK_SCHEDULER_PACKED_TASK ? 16 : CACHE_LINE_SIZE;
+
+// settings most tasks never use, kept out of line (Task::details) so they cost a pointer
+struct TaskDetails {
+    TaskCallback on_complete_callback;
+    std::exception_ptr error;    // what the work threw (FAILED)
+    CancellationToken* token = nullptr;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    size_t memory_estimate = 0;  // bytes the work holds beyond the task itself (admission control)
+    double cost = 1.0;           // estimated run time (any unit), input of computeUpwardRanks()
+    double rank = 0.0;           // longest path to an exit task, orders ready tasks in CRITICAL_PATH mode
+};
+
+// The work fills the first line and the rest of the dispatch data shares the second with the
+// bookkeeping of the owner (written on creation and completion only). The dependency counter
+// hit by every completing predecessor and the successor list get the third line, the only
+// padded one. Rarely used settings live in TaskDetails, so a Task is four lines.
+class alignas(TASK_LINE_SIZE) Task {
+private:
+    // hot: read on dispatch, written only by the executing worker
+    TaskWork work_;
     std::atomic<TaskState> state_;
-    std::function<void()> work_;
+    TaskPriority priority_ = TaskPriority::NORMAL;
+    int16_t numa_node_ = -1; // locality hint: index into Topology::nodes(), -1 = anywhere
+    bool blocking_ = false;  // waits on I/O: runs in the pool's blocking lane, not on a worker
+    bool forwarding_ = false; // only runs another task (ThreadPool::runForwarded)
+    std::atomic<bool> finished_{false}; // the owner is done with it (set by the scheduler)
+
+    // owner bookkeeping
+    uint64_t id_;
+    TaskGroup* group_ = nullptr;
+    Task* next_owned_ = nullptr;        // link in the owner's list of tasks (OwnedTasks)
+    uint64_t ready_ns_ = 0; // when the pool got the task (only stamped while it collects stats)
+    std::unique_ptr<TaskDetails> details_; // allocated by the first setter that needs it
+    void (*destroy_result_)(void*) = nullptr; // set once a result was stored
+
+    // Successor list: lock-free stack of edges pushed by dependents, sealed on completion.
+    // Each edge lives in the dependent it points to (inline for the first few dependencies).
+    struct Edge {
+        Task* successor;
+        Edge* next;
+    };
+    static constexpr uint32_t INLINE_EDGES = 2;
+    static constexpr uint32_t EDGE_CHUNK_SIZE = 16;
+    struct EdgeChunk {
+        Edge edges[EDGE_CHUNK_SIZE];
+        std::unique_ptr<EdgeChunk> next;
+    };
+    std::unique_ptr<EdgeChunk> extra_edges_;
+
+    // written by every completing dependency
+    // (set once the task is owned by a scheduler; dispatched_ guards against double dispatch)
+    alignas(TASK_LINE_SIZE) std::atomic<int> pending_deps_{0};
+    std::atomic<bool> dispatched_{false};
+    // checked once on dispatch (written before submission, or by a cancelled dependency)
+    std::atomic<bool> cancelled_{false};
+    bool skip_dependents_ = false; // cancelled or failed under SKIP_DEPENDENTS
+    bool pooled_ = false; // allocated by a TaskPool, recycled by the scheduler once finished
+    std::atomic<TaskListener*> listener_{nullptr};
+    std::atomic<Edge*> successors_{nullptr};
+    Edge inline_edges_[INLINE_EDGES];
+    uint32_t num_edges_ = 0; // edges owned by this task (one per addDependency call)
+    std::atomic<uint32_t> references_{0}; // value tasks, see retain()
+
+public:
+    static constexpr size_t RESULT_CAPACITY = 32;
+    static constexpr size_t NO_OWNER_THREAD = SIZE_MAX; // not submitted by a thread (graph nodes)
+
+private:
+    // value tasks (task_result.h): the return value lives here if it fits (else on the heap),
+    // kept alive by references from result handles and consumers. Starts the last line, so
+    // the worker storing it does not touch the dependency counter.
+    alignas(TASK_LINE_SIZE) unsigned char result_[RESULT_CAPACITY];
+    size_t owner_thread_ = NO_OWNER_THREAD; // threadShard() of the thread that handed the task over
+
+    TaskDetails& details() {
+        if (!details_) {
+            details_ = std::make_unique<TaskDetails>();
+        }
+        return *details_;
+    }
+
+    void destroyResult() {
+        if (destroy_result_) {
+            destroy_result_(result_);
+            destroy_result_ = nullptr;
+        }
+    }
+
+    void tryDispatch(TaskListener* listener) {
+        bool expected = false;
+        if (dispatched_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            listener->onTaskReady(this);
+        }
+    }
+
+    // Cancelled tasks made ready by a pruning release of this thread. They are skipped
+    // right there instead of going through the pool: a cancelled subgraph is retired in
+    // one pass over its successor lists, without a queue round trip per task.
+    static std::vector<Task*>& prunedTasks() {
+        static thread_local std::vector<Task*> tasks;
+        return tasks;
+    }
+    static bool& pruning() {
+        static thread_local bool active = false;
+        return active;
+    }
 
-    std::atomic<int> pending_deps_{0};
-    std::vector<Task*> dependents_;
-    std::mutex deps_mutex_;
+    // state of a skipped task, then the usual completion (which cancels the dependents)
+    void skip() {
+        state_.store(TaskState::CANCELLED, std::memory_order_release);
+        onComplete();
+    }
 
-    std::function<void(Task*)> on_complete_callback_;
+    // marks a successor list whose task completed; no edge can be added afterwards
+    static Edge* sealed() {
+        static Edge marker{nullptr, nullptr};
+        return &marker;
+    }
+
+    // next unused edge of this task (only called by the thread building this task)
+    Edge* allocateEdge() {
+        uint32_t index = num_edges_++;
+        if (index < INLINE_EDGES) {
+            return &inline_edges_[index];
+        }
+        index -= INLINE_EDGES;
+        if (index % EDGE_CHUNK_SIZE == 0) {
+            auto chunk = std::make_unique<EdgeChunk>();
+            chunk->next = std::move(extra_edges_);
+            extra_edges_ = std::move(chunk);
+        }
+        return &extra_edges_->edges[index % EDGE_CHUNK_SIZE];
+    }
 
 public:
     // disable copying
@@ -32,12 +231,20 @@ public:
     Task& operator=(const Task&) = delete;
 
     // Constructor
-    Task(uint64_t id, std::function<void()> work):
-        id_(id),
+    Task(uint64_t id, TaskWork work):
+        work_(std::move(work)),
         state_(TaskState::PENDING),
-        work_(std::move(work))
+        id_(id)
     {}
 
+    // Destructor (frees edge chunks iteratively, wide fan-in would recurse deeply)
+    ~Task() {
+        destroyResult();
+        while (extra_edges_) {
+            extra_edges_ = std::move(extra_edges_->next);
+        }
+    }
+
     // Getters
     uint64_t getId() const{
         return id_;
@@ -45,40 +252,347 @@ public:
     TaskState getState() const{
         return state_.load(std::memory_order_acquire);
     }
+    TaskGroup* getGroup() const {
+        return group_;
+    }
+    bool isPooled() const {
+        return pooled_;
+    }
+    bool isFinished() const {
+        return finished_.load(std::memory_order_acquire);
+    }
+    Task* getNextOwned() const {
+        return next_owned_;
+    }
+    size_t getOwnerThread() const {
+        return owner_thread_;
+    }
+    TaskPriority getPriority() const {
+        return priority_;
+    }
+    int getNumaNode() const {
+        return numa_node_;
+    }
+    bool isBlocking() const {
+        return blocking_;
+    }
+    bool isForwarding() const {
+        return forwarding_;
+    }
+    size_t getMemoryEstimate() const {
+        return details_ ? details_->memory_estimate : 0;
+    }
+    double getCost() const {
+        return details_ ? details_->cost : 1.0;
+    }
+    double getRank() const {
+        return details_ ? details_->rank : 0.0;
+    }
+    uint64_t getReadyTime() const {
+        return ready_ns_;
+    }
+    std::exception_ptr getError() const {
+        return details_ ? details_->error : nullptr;
+    }
+    // the dependents of this finished task are cancelled (it was cancelled, or failed and
+    // its owner's policy is SKIP_DEPENDENTS); valid from the completion callback on
+    bool cancelsDependents() const {
+        return skip_dependents_;
+    }
+
+    // Setter (priority, call before the task is submitted)
+    void setPriority(TaskPriority priority) {
+        priority_ = priority;
+    }
+
+    // Setter (locality hint: run on a worker of this NUMA node if the pool is pinned)
+    void setNumaNode(int node) {
+        numa_node_ = static_cast<int16_t>(node);
+    }
+
+    // Setter (heap memory held by the work, e.g. its input buffers; counted against
+    // AdmissionLimits::max_bytes together with sizeof(Task). Call before the task is submitted)
+    void setMemoryEstimate(size_t bytes) {
+        details().memory_estimate = bytes;
+    }
+
+    // Setter (the work blocks, e.g. reads a file: it runs in the pool's BlockingLane so it
+    // does not hold a CPU worker; call before the task is submitted)
+    void setBlocking(bool blocking) {
+        blocking_ = blocking;
+    }
+
+    // Setter (the work only runs another task through ThreadPool::runForwarded, which traces
+    // and times that one; the pool does not count the forwarding task itself)
+    void setForwarding(bool forwarding) {
+        forwarding_ = forwarding;
+    }
+
+    // Setters (cost and rank, call before the task is submitted)
+    void setCost(double cost) {
+        details().cost = cost;
+    }
+    void setRank(double rank) {
+        details().rank = rank;
+    }
+
+    // Setter (set by the pool on submission, see statsClockNs)
+    void setReadyTime(uint64_t ns) {
+        ready_ns_ = ns;
+    }
+
+    // Setter (tasks holding token are skipped once it is cancelled)
+    void setCancellationToken(CancellationToken* token) {
+        details().token = token;
+    }
+
+    // Setter (a task that has not started by deadline is skipped like a cancelled one)
+    void setDeadline(std::chrono::steady_clock::time_point deadline) {
+        details().deadline = deadline;
+    }
+
+    // Cancels the task unless it started already: its work is skipped and every task that
+    // depends on it, directly or transitively, is cancelled when it releases them. Their
+    // dependency counts are still released, so waits return. Any thread may call it while
+    // the task is alive (a task from createTask() only until it is submitted; in-flight
+    // pooled tasks are cancelled through a CancellationToken).
+    void cancel() {
+        cancelled_.store(true, std::memory_order_release);
+    }
+
+    // true if the task will be (or was) skipped; running work may poll it to stop early
+    bool isCancelled() const {
+        if (cancelled_.load(std::memory_order_acquire)) {
+            return true;
+        }
+        return details_ && ((details_->token && details_->token->isCancelled()) ||
+                            (details_->deadline != std::chrono::steady_clock::time_point::max() &&
+                             std::chrono::steady_clock::now() > details_->deadline));
+    }
+
+    // Setter (work, call before the task is submitted)
+    void setWork(TaskWork work) {
+        work_ = std::move(work);
+    }
+
+    // Result storage of a value task: RESULT_CAPACITY bytes inside the task, filled by its
+    // work. destroy is called on the storage when the task is destroyed or re-armed.
+    void* resultStorage() {
+        return result_;
+    }
+    bool hasResult() const {
+        return destroy_result_ != nullptr;
+    }
+    void setResultDestructor(void (*destroy)(void*)) {
+        destroy_result_ = destroy;
+    }
+
+    // References keep a finished task (and its result) from being recycled: the owner
+    // holds one until the task finished, result handles and consumers one each.
+    void retain(uint32_t count = 1) {
+        references_.fetch_add(count, std::memory_order_relaxed);
+    }
+    bool isReferenced() const {
+        return references_.load(std::memory_order_relaxed) != 0;
+    }
+    // true for the caller that dropped the last reference: it owns the task now
+    bool release() {
+        return references_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    // drops a reference held outside the owner; the last one hands the task back to it
+    void releaseReference() {
+        if (release()) {
+            listener_.load(std::memory_order_acquire)->onTaskReleased(this);
+        }
+    }
 
     // Setter (callback)
-    void setOnCompleteCallback(std::function<void(Task*)> callback) {
-    on_complete_callback_ = callback;
-}
+    void setOnCompleteCallback(TaskCallback callback) {
+        details().on_complete_callback = std::move(callback);
+    }
+
+    void markPooled() {
+        pooled_ = true;
+    }
+
+    // last access of the owner to a finished task: it may be freed from here on
+    void markFinished() {
+        finished_.store(true, std::memory_order_release);
+    }
+
+    void setNextOwned(Task* next) {
+        next_owned_ = next;
+    }
+    void setOwnerThread(size_t thread) {
+        owner_thread_ = thread;
+    }
+
+    // group that waits for this task (set before the task is handed to a listener)
+    void setGroup(TaskGroup* group) {
+        group_ = group;
+    }
 
-    // executes the task
+    // hands the task to listener as soon as its last dependency is released (exactly once)
+    void setListener(TaskListener* listener) {
+        if (attachListener(listener)) {
+            listener->onTaskReady(this);
+        }
+    }
+
+    // like setListener(), but a task that is ready already is not handed over:
+    // returns true if the caller has to dispatch it (batched submission).
+    // The caller holds an extra count while it publishes the listener, so no completing
+    // dependency can dispatch the task (which may then finish and be recycled) before the
+    // caller is done with it; whoever takes the count to zero dispatches.
+    bool attachListener(TaskListener* listener) {
+        pending_deps_.fetch_add(1, std::memory_order_seq_cst);
+        listener_.store(listener, std::memory_order_seq_cst);
+        if (pending_deps_.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            bool expected = false;
+            return dispatched_.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+        }
+        return false;
+    }
+
+    // executes the task (or skips it if it was cancelled).
+    // An exception thrown by the work is kept in the task and does not leave execute().
     void execute() {
+        if (isCancelled()) {
+            skip();
+            return;
+        }
         state_.store(TaskState::RUNNING, std::memory_order_release);
-        work_();
-        state_.store(TaskState::COMPLETED, std::memory_order_release);
+        try {
+            work_();
+            state_.store(TaskState::COMPLETED, std::memory_order_release);
+        } catch (...) {
+            details().error = std::current_exception();
+            state_.store(TaskState::FAILED, std::memory_order_release);
+        }
         onComplete();
     }
 
-    // adds a task that depends on this task
+    // makes this task wait for dependency (call before this task is submitted).
+    // Safe while dependency is running; if it already completed, the edge counts as satisfied.
     void addDependency(Task* dependency){
+        Edge* edge = allocateEdge();
+        edge->successor = this;
         pending_deps_.fetch_add(1, std::memory_order_relaxed);
-        
-        // Lock mutex of dependency and add this task to its dependents list
-        std::lock_guard<std::mutex> lock(dependency->deps_mutex_);
-        dependency->dependents_.emplace_back(this);  
+
+        Edge* head = dependency->successors_.load(std::memory_order_acquire);
+        do {
+            if (head == sealed()) {
+                // already finished: satisfied, unless it cancels its dependents
+                // (skip_dependents_ is published by the exchange that sealed the list)
+                pending_deps_.fetch_sub(1, std::memory_order_relaxed);
+                if (dependency->cancelsDependents()) {
+                    cancelled_.store(true, std::memory_order_release);
+                }
+                return;
+            }
+            edge->next = head;
+        } while (!dependency->successors_.compare_exchange_weak(head, edge,
+                    std::memory_order_acq_rel, std::memory_order_acquire));
     }
 
     // called on completion of this task
     void onComplete() {
-        std::lock_guard<std::mutex> lock(deps_mutex_);
+        TaskListener* owner = listener_.load(std::memory_order_acquire);
+        TaskState state = state_.load(std::memory_order_relaxed);
+        bool cancelled = state == TaskState::CANCELLED;
+        if (state == TaskState::FAILED) {
+            // without an owner the dependents are skipped
+            cancelled = !owner || owner->onTaskFailed(this) == FailurePolicy::SKIP_DEPENDENTS;
+        }
+        skip_dependents_ = cancelled;
+
+        // seal the list: later addDependency() calls see the task as completed
+        Edge* edge = successors_.exchange(sealed(), std::memory_order_acq_rel);
+        while (edge) {
+            // read the edge before releasing: it belongs to the successor, which may finish right away
+            Task* successor = edge->successor;
+            Edge* next = edge->next;
+            if (cancelled) {
+                successor->releaseCancelled();
+            } else {
+                successor->releaseDependency();
+            }
+            edge = next;
+        }
+
+        if (details_ && details_->on_complete_callback) {
+            details_->on_complete_callback(this);
+        }
+        // last access to this task: the owner may release it from here on
+        if (owner) {
+            owner->onTaskFinished(this);
+        }
+
+        // the outermost pruning completion skips the dependents it made ready (no recursion)
+        if (cancelled && !pruning()) {
+            pruning() = true;
+            std::vector<Task*>& pruned = prunedTasks();
+            while (!pruned.empty()) {
+                Task* task = pruned.back();
+                pruned.pop_back();
+                task->skip();
+            }
+            pruning() = false;
+        }
+    }
+
+    // calls f(successor) for every task that waits for this one (only before this task completed)
+    template <typename F>
+    void forEachSuccessor(F&& f) const {
+        Edge* edge = successors_.load(std::memory_order_acquire);
+        if (edge == sealed()) {
+            return;
+        }
+        for (; edge; edge = edge->next) {
+            f(edge->successor);
+        }
+    }
 
-        for (Task* dependent : dependents_) {
-            dependent->pending_deps_.fetch_sub(1, std::memory_order_relaxed);
+    // one dependency finished; the release that takes the count to zero dispatches the task
+    // (called by completing predecessors, or by an owner that keeps the edges itself)
+    void releaseDependency() {
+        if (pending_deps_.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            TaskListener* listener = listener_.load(std::memory_order_seq_cst);
+            if (listener) {
+                tryDispatch(listener);
+            }
         }
+    }
+
+    // a cancelled dependency finished: this task is cancelled as well. If that was its last
+    // dependency, it is skipped on this thread instead of being dispatched.
+    void releaseCancelled() {
+        cancelled_.store(true, std::memory_order_relaxed); // published by the release below
+        if (pending_deps_.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            TaskListener* listener = listener_.load(std::memory_order_seq_cst);
+            bool expected = false;
+            if (listener && dispatched_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                prunedTasks().push_back(this);
+            }
+        }
+    }
 
-        if (on_complete_callback_) {
-            on_complete_callback_(this);
+    // Re-arms a completed task for another run (TaskGraph replay). The task has no
+    // successor list afterwards, its pending_deps dependencies are released by hand.
+    // Only call it while no thread can touch the task.
+    void rearm(int pending_deps) {
+        state_.store(TaskState::PENDING, std::memory_order_relaxed);
+        pending_deps_.store(pending_deps, std::memory_order_relaxed);
+        dispatched_.store(false, std::memory_order_relaxed);
+        cancelled_.store(false, std::memory_order_relaxed);
+        finished_.store(false, std::memory_order_relaxed);
+        if (details_) {
+            details_->error = nullptr;
         }
+        skip_dependents_ = false;
+        destroyResult();
+        successors_.store(nullptr, std::memory_order_relaxed);
+        ready_ns_ = 0;
     }
 
     bool isReady() const {
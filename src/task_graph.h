@@ -0,0 +1,209 @@
+// src/task_graph.h
+#pragma once
+
+#include "kernel_registry.h"
+#include "task.h"
+#include "task_group.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class GraphSnapshot;
+class TaskScheduler;
+
+// A DAG that is built once and run many times (TaskScheduler::run).
+// freeze() packs the edges into CSR form (per node an offset into one successor
+// array) with precomputed in-degrees. Every node owns one Task that is reused by
+// all runs: a replay only re-arms the counters, nothing is allocated or wired.
+// The nodes release their successors from the CSR, the Tasks carry no edges.
+// A cancelled node (Task::cancel, a token or a deadline) cancels its successors as well,
+// so does a failed node under FailurePolicy::SKIP_DEPENDENTS.
+// A graph of kernel nodes (addNode(registry, kernel, params)) can be saved with
+// GraphSnapshot::write and mapped back in another process.
+class TaskGraph {
+private:
+    std::vector<TaskWork> works_;              // user work per node
+    std::vector<std::unique_ptr<Task>> owned_; // carrier task per node, reused by every run
+    std::vector<Task*> tasks_;                 // same tasks as a span for the scheduler
+    std::vector<std::pair<uint32_t, uint32_t>> edges_; // (dependency, dependent) until frozen
+    std::vector<KernelCall> kernel_calls_; // per node, KernelCall::NONE for TaskWork nodes
+    std::vector<unsigned char> params_;    // parameter blobs of the kernel nodes
+
+    // CSR: successors of node i are successors_[offsets_[i] .. offsets_[i + 1])
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> successors_;
+    std::vector<int> in_degree_;
+    bool frozen_ = false;
+
+    std::vector<Task*> ready_; // scratch for the scheduler: tasks (or tokens) ready at start
+    TaskGroup finished_;       // tasks of the current run that have not finished
+
+    friend class GraphSnapshot;
+    friend class TaskScheduler;
+
+    // completion of node's task (after its work ran or was skipped): releases the successors
+    void finishNode(uint32_t node, const Task* task) {
+        bool cancelled = task->cancelsDependents();
+        for (uint32_t k = offsets_[node]; k < offsets_[node + 1]; ++k) {
+            if (cancelled) {
+                tasks_[successors_[k]]->releaseCancelled();
+            } else {
+                tasks_[successors_[k]]->releaseDependency();
+            }
+        }
+    }
+
+    // resets every node for the next run (the previous run has finished)
+    void rearm() {
+        for (size_t i = 0; i < tasks_.size(); ++i) {
+            tasks_[i]->rearm(in_degree_[i]);
+        }
+        finished_.add(tasks_.size());
+    }
+
+    // graph changes after freeze(): back to the edge list, keeping the edges in the CSR
+    void thaw() {
+        if (!frozen_) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < offsets_.size(); ++i) {
+            for (uint32_t k = offsets_[i]; k < offsets_[i + 1]; ++k) {
+                edges_.emplace_back(static_cast<uint32_t>(i), successors_[k]);
+            }
+        }
+        frozen_ = false;
+    }
+
+public:
+    // disable copying (the tasks point back into the graph)
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Constructor
+    TaskGraph() = default;
+
+    // Getters
+    size_t size() const {
+        return tasks_.size();
+    }
+    size_t numEdges() const {
+        return frozen_ ? successors_.size() : edges_.size();
+    }
+    bool isFrozen() const {
+        return frozen_;
+    }
+
+    // task of node, for priority, cost, locality hints or a cancellation token / deadline
+    // (do not wire or submit it, and leave its completion callback alone; every run
+    // re-arms the task, which clears a Task::cancel() from before)
+    Task& task(size_t node) {
+        return *tasks_[node];
+    }
+
+    // adds a node and returns its index (the task id is the index as well)
+    size_t addNode(TaskWork work) {
+        uint32_t node = static_cast<uint32_t>(tasks_.size());
+        works_.push_back(std::move(work));
+        kernel_calls_.emplace_back();
+        owned_.push_back(std::make_unique<Task>(node, [this, node]() {
+            works_[node]();
+        }));
+        owned_.back()->setOnCompleteCallback([this, node](Task* task) {
+            finishNode(node, task);
+        });
+        tasks_.push_back(owned_.back().get());
+        tasks_.back()->setGroup(&finished_);
+        thaw();
+        return node;
+    }
+
+    // adds a node that runs kernel of registry with a copy of params (size bytes); only
+    // graphs made of such nodes can be saved (GraphSnapshot::write)
+    size_t addNode(KernelRegistry& registry, uint32_t kernel, const void* params = nullptr, size_t size = 0) {
+        KernelCall call;
+        call.kernel = kernel;
+        call.param_size = static_cast<uint32_t>(size);
+        call.param_offset = params_.size();
+        params_.resize(params_.size() + size);
+        if (size > 0) {
+            std::memcpy(params_.data() + call.param_offset, params, size);
+        }
+        uint32_t node = static_cast<uint32_t>(tasks_.size());
+        size_t index = addNode([this, &registry, node]() {
+            const KernelCall& call = kernel_calls_[node];
+            registry.call(call.kernel, KernelParams{params_.data() + call.param_offset, call.param_size, node});
+        });
+        kernel_calls_[node] = call;
+        return index;
+    }
+
+    // node waits for dependency (both returned by addNode)
+    void addDependency(size_t node, size_t dependency) {
+        thaw();
+        edges_.emplace_back(static_cast<uint32_t>(dependency), static_cast<uint32_t>(node));
+    }
+
+    // Packs the edges into CSR form and ranks the nodes by their costs (for
+    // CRITICAL_PATH). Returns false if the graph has a cycle; it cannot run then.
+    // TaskScheduler::run() freezes on demand.
+    bool freeze() {
+        if (frozen_) {
+            return true;
+        }
+        size_t n = tasks_.size();
+        offsets_.assign(n + 1, 0);
+        in_degree_.assign(n, 0);
+        for (const auto& edge : edges_) {
+            ++offsets_[edge.first + 1];
+            ++in_degree_[edge.second];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            offsets_[i + 1] += offsets_[i];
+        }
+        successors_.resize(edges_.size());
+        std::vector<uint32_t> cursor(offsets_.begin(), offsets_.end() - 1);
+        for (const auto& edge : edges_) {
+            successors_[cursor[edge.first]++] = edge.second;
+        }
+
+        // Kahn order, ranks are assigned in reverse (see computeUpwardRanks)
+        std::vector<int> remaining = in_degree_;
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (remaining[i] == 0) {
+                order.push_back(i);
+            }
+        }
+        size_t num_roots = order.size();
+        for (size_t head = 0; head < order.size(); ++head) {
+            uint32_t node = order[head];
+            for (uint32_t k = offsets_[node]; k < offsets_[node + 1]; ++k) {
+                if (--remaining[successors_[k]] == 0) {
+                    order.push_back(successors_[k]);
+                }
+            }
+        }
+        if (order.size() != n) {
+            return false;
+        }
+        for (size_t i = n; i-- > 0;) {
+            uint32_t node = order[i];
+            double longest = 0.0;
+            for (uint32_t k = offsets_[node]; k < offsets_[node + 1]; ++k) {
+                longest = std::max(longest, tasks_[successors_[k]]->getRank());
+            }
+            tasks_[node]->setRank(tasks_[node]->getCost() + longest);
+        }
+
+        edges_.clear();
+        edges_.shrink_to_fit();
+        ready_.reserve(num_roots);
+        frozen_ = true;
+        return true;
+    }
+};
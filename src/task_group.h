@@ -0,0 +1,61 @@
+// src/task_group.h
+#pragma once
+
+#include "cache_line.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+// Counts outstanding tasks; wait() parks the caller until the count drops to zero.
+class TaskGroup {
+private:
+    // hit by every finishing task, waiters only touch the lock line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> outstanding_{0};
+    alignas(CACHE_LINE_SIZE) std::mutex mutex_;
+    std::condition_variable condition_;
+
+public:
+    // disable copying
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Constructor
+    TaskGroup() = default;
+
+    // Getter
+    size_t pending() const {
+        return outstanding_.load(std::memory_order_acquire);
+    }
+
+    // registers count new tasks
+    void add(size_t count = 1) {
+        outstanding_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // called once per finished task
+    void done() {
+        size_t current = outstanding_.load(std::memory_order_relaxed);
+        // not the last one -> lock-free decrement
+        while (current > 1) {
+            if (outstanding_.compare_exchange_weak(current, current - 1,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        // the last decrement happens under the lock, so a waiter can neither miss
+        // the notification nor return (and destroy the group) before we are done with it
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            condition_.notify_all();
+        }
+    }
+
+    // blocks without spinning until all registered tasks are done
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]{
+            return outstanding_.load(std::memory_order_acquire) == 0;
+        });
+    }
+};
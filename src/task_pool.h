@@ -0,0 +1,251 @@
+// src/task_pool.h
+#pragma once
+
+#include "cache_line.h"
+#include "task.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Slab allocator for Task objects.
+// Every worker has its own free list (no locking); threads outside the pool are
+// spread over a few locked lists (threadShard). Slots move between threads in
+// batches through a global list, new slabs are only carved when that list is empty.
+class TaskPool {
+private:
+    static constexpr size_t SLAB_SIZE = 256;  // tasks per slab
+    static constexpr size_t BATCH_SIZE = 64;  // slots moved between lists at once
+    static constexpr size_t EXTERNAL_SHARDS = 8; // free lists for threads outside the pool
+
+    union Slot {
+        Slot* next;
+        alignas(Task) unsigned char storage[sizeof(Task)];
+    };
+
+    struct FreeList {
+        Slot* head = nullptr;
+        size_t count = 0;
+
+        void push(Slot* slot) {
+            slot->next = head;
+            head = slot;
+            ++count;
+        }
+        Slot* pop() {
+            Slot* slot = head;
+            head = slot->next;
+            --count;
+            return slot;
+        }
+    };
+
+    // one cache line per worker, only touched by that worker
+    struct alignas(CACHE_LINE_SIZE) WorkerCache {
+        FreeList list;
+    };
+
+    // shared by the outside threads that map to it
+    struct alignas(CACHE_LINE_SIZE) ExternalCache {
+        std::mutex mutex;
+        FreeList list;
+    };
+
+    std::vector<WorkerCache> worker_caches_;
+    ExternalCache external_caches_[EXTERNAL_SHARDS];
+
+    alignas(CACHE_LINE_SIZE) std::mutex global_mutex_;
+    std::vector<FreeList> global_batches_;
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+
+    // one batch from the global list, or a fresh slab
+    FreeList refill() {
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        if (!global_batches_.empty()) {
+            FreeList batch = global_batches_.back();
+            global_batches_.pop_back();
+            return batch;
+        }
+        slabs_.push_back(std::make_unique<Slot[]>(SLAB_SIZE));
+        FreeList batch;
+        for (size_t i = 0; i < SLAB_SIZE; ++i) {
+            batch.push(&slabs_.back()[i]);
+        }
+        return batch;
+    }
+
+    // hands BATCH_SIZE slots of list back to the global list
+    void flush(FreeList& list) {
+        FreeList batch;
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            batch.push(list.pop());
+        }
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        global_batches_.push_back(batch);
+    }
+
+    Slot* acquire(int worker) {
+        if (worker >= 0) {
+            FreeList& list = worker_caches_[worker].list;
+            if (list.count == 0) {
+                list = refill();
+            }
+            return list.pop();
+        }
+        ExternalCache& cache = external_caches_[threadShard() % EXTERNAL_SHARDS];
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (cache.list.count == 0) {
+            cache.list = refill();
+        }
+        return cache.list.pop();
+    }
+
+    void release(int worker, Slot* slot) {
+        if (worker >= 0) {
+            FreeList& list = worker_caches_[worker].list;
+            list.push(slot);
+            if (list.count >= 2 * BATCH_SIZE) {
+                flush(list);
+            }
+            return;
+        }
+        ExternalCache& cache = external_caches_[threadShard() % EXTERNAL_SHARDS];
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.list.push(slot);
+        if (cache.list.count >= 2 * BATCH_SIZE) {
+            flush(cache.list);
+        }
+    }
+
+public:
+    // disable copying
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Constructor (num_workers = worker count of the ThreadPool that recycles the tasks)
+    explicit TaskPool(size_t num_workers):
+        worker_caches_(num_workers)
+    {}
+
+    // constructs a Task in a free slot; worker = ThreadPool::currentWorker() of the caller
+    template <typename... Args>
+    Task* create(int worker, Args&&... args) {
+        Slot* slot = acquire(worker);
+        Task* task;
+        try {
+            task = new (slot->storage) Task(std::forward<Args>(args)...);
+        } catch (...) {
+            release(worker, slot);
+            throw;
+        }
+        task->markPooled();
+        return task;
+    }
+
+    // destroys a task created by this pool and recycles its slot
+    void destroy(int worker, Task* task) {
+        task->~Task();
+        release(worker, reinterpret_cast<Slot*>(task));
+    }
+
+    // number of task slots allocated so far
+    size_t capacity() {
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        return slabs_.size() * SLAB_SIZE;
+    }
+};
+
+// Tasks handed over as unique_ptr, kept alive until they finished (Task::markFinished)
+// and freed by release() on the thread that added them, so another producer's wait never
+// frees a task its thread may still point to. Any thread may add: the tasks are pushed
+// onto one of several lock-free stacks (threadShard), linked through the tasks themselves.
+class OwnedTasks {
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+    CachePadded<std::atomic<Task*>> heads_[NUM_SHARDS];
+
+    // pushes the chain first .. last (linked already)
+    void push(Task* first, Task* last) {
+        std::atomic<Task*>& head = *heads_[threadShard() % NUM_SHARDS];
+        Task* old_head = head.load(std::memory_order_relaxed);
+        do {
+            last->setNextOwned(old_head);
+        } while (!head.compare_exchange_weak(old_head, first, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+public:
+    // disable copying
+    OwnedTasks(const OwnedTasks&) = delete;
+    OwnedTasks& operator=(const OwnedTasks&) = delete;
+
+    // Constructor
+    OwnedTasks():
+        heads_{}
+    {}
+
+    // Destructor (the tasks must have finished or never been submitted)
+    ~OwnedTasks() {
+        for (auto& head : heads_) {
+            Task* task = head->exchange(nullptr, std::memory_order_acquire);
+            while (task) {
+                Task* next = task->getNextOwned();
+                delete task;
+                task = next;
+            }
+        }
+    }
+
+    // takes over task (any thread); release() frees it on thread (by default the caller)
+    Task* add(std::unique_ptr<Task> task, size_t thread = threadShard()) {
+        Task* raw_task = task.release();
+        raw_task->setOwnerThread(thread);
+        push(raw_task, raw_task);
+        return raw_task;
+    }
+
+    // takes over all tasks with one push (any thread)
+    void add(std::vector<std::unique_ptr<Task>>& tasks, size_t thread = threadShard()) {
+        if (tasks.empty()) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < tasks.size(); ++i) {
+            tasks[i]->setNextOwned(tasks[i + 1].get());
+        }
+        for (auto& task : tasks) {
+            task->setOwnerThread(thread);
+        }
+        Task* first = tasks.front().get();
+        Task* last = tasks.back().get();
+        for (auto& task : tasks) {
+            task.release();
+        }
+        push(first, last);
+    }
+
+    // frees the finished tasks the calling thread added; the others stay (tasks of other
+    // threads sharing the stack, tasks not finished yet)
+    void release() {
+        size_t thread = threadShard();
+        Task* task = heads_[thread % NUM_SHARDS]->exchange(nullptr, std::memory_order_acquire);
+        Task* keep_first = nullptr;
+        Task* keep_last = nullptr;
+        while (task) {
+            Task* next = task->getNextOwned();
+            if (task->getOwnerThread() == thread && task->isFinished()) {
+                delete task;
+            } else {
+                task->setNextOwned(keep_first);
+                keep_first = task;
+                keep_last = keep_last ? keep_last : task;
+            }
+            task = next;
+        }
+        if (keep_first) {
+            push(keep_first, keep_last);
+        }
+    }
+};
@@ -0,0 +1,268 @@
+// src/task_result.h
+#pragma once
+
+#include "task.h"
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Value tasks: TaskScheduler::submit(fn, inputs...) keeps fn's return value inside the
+// task's slot (Task::resultStorage, heap only for large values) and hands the results of
+// its inputs to fn by reference. A finished value task is recycled once the last
+// TaskResult handle and the last consumer let go of it.
+
+template <typename R>
+class TaskResult;
+
+// where a value of type T lives in a task
+template <typename T>
+struct ResultSlot {
+    static constexpr bool fits_inline = sizeof(T) <= Task::RESULT_CAPACITY && alignof(T) <= 16;
+
+    template <typename U>
+    static void store(Task* task, U&& value) {
+        if constexpr (fits_inline) {
+            new (task->resultStorage()) T(std::forward<U>(value));
+            task->setResultDestructor([](void* storage) {
+                static_cast<T*>(storage)->~T();
+            });
+        } else {
+            new (task->resultStorage()) T*(new T(std::forward<U>(value)));
+            task->setResultDestructor([](void* storage) {
+                delete *static_cast<T**>(storage);
+            });
+        }
+    }
+
+    static T& get(Task* task) {
+        if constexpr (fits_inline) {
+            return *std::launder(static_cast<T*>(task->resultStorage()));
+        } else {
+            return **static_cast<T**>(task->resultStorage());
+        }
+    }
+};
+
+// rethrows what a finished task threw, throws if it was cancelled
+inline void checkTaskResult(Task* task) {
+    TaskState state = task->getState();
+    if (state == TaskState::FAILED) {
+        std::rethrow_exception(task->getError());
+    }
+    if (state == TaskState::CANCELLED) {
+        throw std::runtime_error("task " + std::to_string(task->getId()) + " was cancelled");
+    }
+}
+
+// what fn receives for an input passed as Input (as deduced by a forwarding reference):
+// const T& for a handle passed as lvalue, T&& for one passed as rvalue, nothing for void
+template <typename Input>
+struct ResultArg;
+
+template <typename T>
+struct ResultArg<TaskResult<T>&> {
+    static auto get(Task* task) {
+        if constexpr (std::is_void_v<T>) {
+            return std::tuple<>();
+        } else {
+            return std::tuple<const T&>(ResultSlot<T>::get(task));
+        }
+    }
+};
+template <typename T>
+struct ResultArg<const TaskResult<T>&> : ResultArg<TaskResult<T>&> {};
+
+template <typename T>
+struct ResultArg<TaskResult<T>> {
+    static auto get(Task* task) {
+        if constexpr (std::is_void_v<T>) {
+            return std::tuple<>();
+        } else {
+            return std::tuple<T&&>(std::move(ResultSlot<T>::get(task)));
+        }
+    }
+};
+
+template <typename T>
+struct IsTaskResult : std::false_type {};
+template <typename T>
+struct IsTaskResult<TaskResult<T>> : std::true_type {};
+
+// arguments fn receives for Inputs, as a tuple type
+template <typename... Inputs>
+using ValueArgs = decltype(std::tuple_cat(ResultArg<Inputs>::get(nullptr)...));
+
+template <typename F, typename Args>
+struct ValueInvoke;
+template <typename F, typename... Args>
+struct ValueInvoke<F, std::tuple<Args...>> {
+    static constexpr bool invocable = std::is_invocable_v<std::decay_t<F>&, Args...>;
+    using result = std::invoke_result_t<std::decay_t<F>&, Args...>;
+};
+
+// fn can be called with the results of Inputs
+template <typename F, typename... Inputs>
+constexpr bool is_value_invocable = ValueInvoke<F, ValueArgs<Inputs...>>::invocable;
+
+// stored return type of fn called with the results of Inputs
+template <typename F, typename... Inputs>
+using ValueResult = std::decay_t<typename ValueInvoke<F, ValueArgs<Inputs...>>::result>;
+
+// fn of a value task; an empty one (a lambda without captures) takes no space, so the
+// work of a task with up to five inputs stays within TaskWork's inline storage
+template <typename F, bool = std::is_empty_v<F> && !std::is_final_v<F>>
+class ValueFn {
+private:
+    F fn_;
+
+public:
+    template <typename G>
+    explicit ValueFn(G&& fn): fn_(std::forward<G>(fn)) {}
+    F& fn() {
+        return fn_;
+    }
+};
+template <typename F>
+class ValueFn<F, true> : private F {
+public:
+    template <typename G>
+    explicit ValueFn(G&& fn): F(std::forward<G>(fn)) {}
+    F& fn() {
+        return *this;
+    }
+};
+
+// Work of a value task: calls fn with the results of its inputs, stores the return value
+// in the task and drops the references to the inputs right away (or when it is destroyed
+// without having run, e.g. cancelled).
+template <typename R, typename F, typename... Inputs>
+class ValueWork : private ValueFn<F> {
+private:
+    Task* self_;
+    std::array<Task*, sizeof...(Inputs)> inputs_;
+
+    void releaseInputs() noexcept {
+        for (Task*& input : inputs_) {
+            if (input) {
+                input->releaseReference();
+                input = nullptr;
+            }
+        }
+    }
+
+    template <size_t... I>
+    decltype(auto) invoke(std::index_sequence<I...>) {
+        // an input that failed (dependents run under FailurePolicy::RUN_DEPENDENTS) fails us too
+        (checkTaskResult(inputs_[I]), ...);
+        return std::apply(this->fn(), std::tuple_cat(ResultArg<Inputs>::get(inputs_[I])...));
+    }
+
+public:
+    // takes over one reference of every input
+    template <typename G>
+    ValueWork(Task* self, G&& fn, const std::array<Task*, sizeof...(Inputs)>& inputs):
+        ValueFn<F>(std::forward<G>(fn)),
+        self_(self),
+        inputs_(inputs)
+    {}
+
+    ValueWork(const ValueWork&) = delete;
+    ValueWork& operator=(const ValueWork&) = delete;
+    ValueWork(ValueWork&& other) noexcept(std::is_nothrow_move_constructible_v<F>):
+        ValueFn<F>(std::move(other.fn())),
+        self_(other.self_),
+        inputs_(other.inputs_)
+    {
+        other.inputs_.fill(nullptr);
+    }
+
+    ~ValueWork() {
+        releaseInputs();
+    }
+
+    void operator()() {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                invoke(std::index_sequence_for<Inputs...>());
+            } else {
+                ResultSlot<R>::store(self_, invoke(std::index_sequence_for<Inputs...>()));
+            }
+        } catch (...) {
+            releaseInputs();
+            throw;
+        }
+        releaseInputs();
+    }
+};
+
+// Handle to the result of a value task. Copies share the task; it stays alive (and is not
+// recycled) while a handle or an unfinished consumer refers to it. Drop handles before the
+// scheduler is destroyed.
+template <typename R>
+class TaskResult {
+private:
+    Task* task_ = nullptr;
+
+public:
+    TaskResult() = default;
+
+    // takes over one reference of task
+    explicit TaskResult(Task* task) noexcept:
+        task_(task)
+    {}
+
+    TaskResult(const TaskResult& other):
+        task_(other.task_)
+    {
+        if (task_) {
+            task_->retain();
+        }
+    }
+    TaskResult(TaskResult&& other) noexcept:
+        task_(std::exchange(other.task_, nullptr))
+    {}
+    TaskResult& operator=(TaskResult other) noexcept {
+        std::swap(task_, other.task_);
+        return *this;
+    }
+
+    // Destructor
+    ~TaskResult() {
+        reset();
+    }
+
+    // Getters
+    Task* task() const {
+        return task_;
+    }
+    explicit operator bool() const {
+        return task_ != nullptr;
+    }
+
+    // The return value, once the task finished (after a wait, or from a consumer).
+    // Rethrows what the task threw; throws std::runtime_error if it was cancelled.
+    decltype(auto) get() const {
+        checkTaskResult(task_);
+        if constexpr (!std::is_void_v<R>) {
+            return static_cast<const R&>(ResultSlot<R>::get(task_));
+        }
+    }
+
+    // drops the reference (the task may be recycled afterwards)
+    void reset() {
+        if (task_) {
+            std::exchange(task_, nullptr)->releaseReference();
+        }
+    }
+
+    // gives up the handle without dropping its reference, which now belongs to the caller
+    Task* detach() noexcept {
+        return std::exchange(task_, nullptr);
+    }
+};
@@ -1,46 +1,318 @@
 // src/task_scheduler.h
 #pragma once
 
+#include "admission_control.h"
+#include "critical_path.h"
+#include "graph_snapshot.h"
 #include "task.h"
+#include "task_graph.h"
+#include "task_group.h"
+#include "task_pool.h"
+#include "task_result.h"
 #include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <vector>
-#include <mutex>
 #include <memory>
-#include <thread>
-#include <algorithm>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+// exception of a failed task, as collected by the scheduler
+struct TaskError {
+    uint64_t task_id;
+    std::exception_ptr error;
+};
 
-class TaskScheduler {
+class TaskScheduler : private TaskListener {
 private:
-    ThreadPool pool_;
-    std::vector<std::unique_ptr<Task>> owned_tasks_;
-    std::vector<Task*> all_tasks_;
-    std::vector<Task*> pending_tasks_;
-    std::mutex pending_mutex_;
+    // owner of the dispatch tokens of CRITICAL_PATH mode: queues them, recycles them afterwards
+    class TokenListener : public TaskListener {
+    private:
+        TaskScheduler& scheduler_;
+    public:
+        explicit TokenListener(TaskScheduler& scheduler): scheduler_(scheduler) {}
+        void onTaskReady(Task* token) override {
+            scheduler_.pool_.submit(token);
+        }
+        void onTaskFinished(Task* token) override {
+            scheduler_.task_pool_.destroy(scheduler_.pool_.currentWorker(), token);
+        }
+    };
 
-    // callback to wake up tasks when dependencies are completed
-    void onTaskCompleted(Task* completed_task) {
-        std::vector<Task*> rdy_tasks;
+    OwnedTasks owned_tasks_; // unique_ptr tasks, freed by their submitter's next waitAll() once finished
+    TaskPool task_pool_; // tasks from createTask(), recycled as soon as they finished
+    TaskGroup outstanding_; // every submitted task that has not finished yet
+    CachePadded<std::atomic<uint64_t>> next_id_{0}; // ids for tasks built by submit(F&&)
+    SchedulingPolicy policy_ = SchedulingPolicy::FIFO;
+    FailurePolicy failure_policy_ = FailurePolicy::SKIP_DEPENDENTS;
+    // a failure not reported yet, with the wait scopes that may report it
+    struct PendingError {
+        TaskError error;
+        const TaskGroup* group; // run(graph), run(snapshot) or wait(group)
+        size_t thread;          // waitAll() of the submitting thread (Task::getOwnerThread)
+    };
+    std::mutex errors_mutex_;
+    std::vector<PendingError> errors_; // failure path only
+    std::unordered_map<size_t, std::vector<TaskError>> reported_; // by threadShard(): its last wait that threw
+    AdmissionControl admission_; // optional limits on the tasks held at once
+    RankedReadyQueue ranked_ready_[NUM_PRIORITIES]; // CRITICAL_PATH mode: ready tasks per priority
+    TokenListener token_listener_{*this};
+    ThreadPool pool_; // declared last: workers are joined before the tasks are freed
 
-        {
-            std::lock_guard<std::mutex> lock(pending_mutex_);
+    // Task::getOwnerThread() of tasks submitted from inside the pool: nobody waits there,
+    // so their failures go to the next waitAll() of any thread
+    static constexpr size_t POOL_THREAD = Task::NO_OWNER_THREAD - 1;
 
-            for (Task* task : pending_tasks_) {
-                if (task->isReady()) {
-                    rdy_tasks.push_back(task);
+    uint64_t nextId() {
+        return next_id_->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // bytes a task is charged with under AdmissionLimits::max_bytes
+    static size_t footprint(const Task* task) {
+        return sizeof(Task) + task->getMemoryEstimate();
+    }
+
+    static std::chrono::steady_clock::time_point deadlineAfter(std::chrono::steady_clock::duration timeout) {
+        if (timeout <= std::chrono::steady_clock::duration::zero()) {
+            return std::chrono::steady_clock::time_point::min();
+        }
+        return std::chrono::steady_clock::now() + timeout;
+    }
+
+    // Takes capacity for tasks about to be submitted (a no-op without limits). Workers of the
+    // pool never wait: a running task that spawns work would hold capacity while it waits.
+    bool admit(size_t tasks, size_t bytes,
+               std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        if (!admission_.limited()) {
+            return true;
+        }
+        if (pool_.currentWorker() >= 0) {
+            admission_.force(tasks, bytes);
+            return true;
+        }
+        return admission_.acquire(tasks, bytes, deadline);
+    }
+
+    // admitted task -> the scheduler (or another owner that hands it back, see SnapshotRun)
+    void enqueue(Task* task, TaskListener* owner) {
+        outstanding_.add();
+
+        // dispatched now if ready, otherwise by the dependency that completes last
+        task->setListener(owner);
+    }
+    void enqueue(Task* task) {
+        setSubmitter(task, submittingThread());
+        enqueue(task, this);
+    }
+
+    // called by the task whose completion released the last dependency (or by submit)
+    void onTaskReady(Task* task) override {
+        // blocking tasks skip the ranking: they go straight to the pool's blocking lane
+        if (policy_ == SchedulingPolicy::CRITICAL_PATH && !task->isBlocking()) {
+            rankToken(task)->setListener(&token_listener_);
+            return;
+        }
+        pool_.submit(task);
+    }
+
+    // CRITICAL_PATH mode: the pool gets one token per ready task, with its priority and
+    // locality hint; a worker that picks a token runs whichever ready task of that priority
+    // ranks highest at that moment (not necessarily this one), traced and timed as that task
+    Task* rankToken(Task* task) {
+        TaskPriority priority = task->getPriority();
+        ranked_ready_[static_cast<size_t>(priority)].push(task);
+        Task* token = task_pool_.create(pool_.currentWorker(), task->getId(), TaskWork());
+        token->setWork([this, token, priority]() {
+            Task* ranked = ranked_ready_[static_cast<size_t>(priority)].pop();
+            ranked->setReadyTime(token->getReadyTime());
+            pool_.runForwarded(ranked);
+        });
+        token->setPriority(priority);
+        token->setNumaNode(task->getNumaNode());
+        token->setForwarding(true);
+        return token;
+    }
+
+    // takes over task; returns what the pool has to run if it is ready already
+    // (the task itself, or its token in CRITICAL_PATH mode), nullptr otherwise
+    Task* attach(Task* task) {
+        if (!task->attachListener(this)) {
+            return nullptr;
+        }
+        if (policy_ == SchedulingPolicy::CRITICAL_PATH && !task->isBlocking()) {
+            Task* token = rankToken(task);
+            token->attachListener(&token_listener_);
+            return token;
+        }
+        return task;
+    }
+
+    // a task threw: keep the exception for the wait that covers it
+    FailurePolicy onTaskFailed(Task* task) override {
+        std::lock_guard<std::mutex> lock(errors_mutex_);
+        errors_.push_back(PendingError{TaskError{task->getId(), task->getError()}, task->getGroup(),
+                                       task->getOwnerThread()});
+        return failure_policy_;
+    }
+
+    // thread a task submitted now is reported to (see POOL_THREAD)
+    size_t submittingThread() const {
+        return pool_.currentWorker() >= 0 ? POOL_THREAD : threadShard();
+    }
+    // owned tasks got it from OwnedTasks::add already; another thread's release() may be
+    // reading it then, so it is only written when it differs
+    static void setSubmitter(Task* task, size_t thread) {
+        if (task->getOwnerThread() != thread) {
+            task->setOwnerThread(thread);
+        }
+    }
+
+    // Rethrows the first exception of the unreported failures of one wait scope: the tasks
+    // of group, or without one those the calling thread (or the pool) submitted
+    void rethrowErrors(const TaskGroup* group) {
+        size_t thread = threadShard();
+        std::vector<TaskError> failed;
+        {
+            std::lock_guard<std::mutex> lock(errors_mutex_);
+            if (errors_.empty()) {
+                return;
+            }
+            auto covered = [group, thread](const PendingError& pending) {
+                return group ? pending.group == group : pending.thread == thread || pending.thread == POOL_THREAD;
+            };
+            for (const PendingError& pending : errors_) {
+                if (covered(pending)) {
+                    failed.push_back(pending.error);
                 }
             }
+            if (failed.empty()) {
+                return;
+            }
+            errors_.erase(std::remove_if(errors_.begin(), errors_.end(), covered), errors_.end());
+            reported_[thread] = failed;
+        }
+        std::rethrow_exception(failed.front().error);
+    }
+
+    // called as the very last step of a task; the caller's group is released first
+    void onTaskFinished(Task* task) override {
+        if (admission_.limited()) {
+            admission_.release(1, footprint(task));
+        }
+        TaskGroup* group = task->getGroup();
+        // dependents were released already; only result handles and consumers may still
+        // reference a value task, the last of them hands it back (onTaskReleased)
+        if (task->isPooled()) {
+            if (!task->isReferenced() || task->release()) {
+                task_pool_.destroy(pool_.currentWorker(), task);
+            }
+        } else {
+            task->markFinished();
+        }
+        if (group) {
+            group->done();
+        }
+        outstanding_.done();
+    }
+
+    // the last reference to a finished value task was dropped
+    void onTaskReleased(Task* task) override {
+        task_pool_.destroy(pool_.currentWorker(), task);
+    }
+
+    // one reference of input for a consumer: a handle passed as rvalue hands its own over
+    template <typename R>
+    static Task* takeInput(TaskResult<R>& input) {
+        input.task()->retain();
+        return input.task();
+    }
+    template <typename R>
+    static Task* takeInput(const TaskResult<R>& input) {
+        input.task()->retain();
+        return input.task();
+    }
+    template <typename R>
+    static Task* takeInput(TaskResult<R>&& input) {
+        return input.detach();
+    }
+
+    // One run of a GraphSnapshot: finished dependencies per node, SNAPSHOT_SKIP once a
+    // cancelled (or skipping failed) dependency finished. Owns the tasks of the run and
+    // releases the successors of a node before handing its task back to the scheduler.
+    class SnapshotRun : public TaskListener {
+    public:
+        TaskScheduler& scheduler;
+        const GraphSnapshot& snapshot;
+        KernelRegistry& registry;
+        std::unique_ptr<std::atomic<uint32_t>[]> released;
+        TaskGroup finished;
+
+        SnapshotRun(TaskScheduler& scheduler, const GraphSnapshot& snapshot, KernelRegistry& registry)
+            : scheduler(scheduler), snapshot(snapshot), registry(registry),
+              released(std::make_unique<std::atomic<uint32_t>[]>(snapshot.size())) {}
 
-            for (Task* task : rdy_tasks) {
-                pending_tasks_.erase(
-                    std::remove(pending_tasks_.begin(),pending_tasks_.end(), task), 
-                    pending_tasks_.end()
-                );
+        void onTaskReady(Task* task) override {
+            scheduler.onTaskReady(task);
+        }
+        FailurePolicy onTaskFailed(Task* task) override {
+            return scheduler.onTaskFailed(task);
+        }
+        void onTaskFinished(Task* task) override {
+            uint32_t node = static_cast<uint32_t>(task->getId());
+            bool cancelled = task->cancelsDependents();
+            for (const uint32_t* it = snapshot.successorsBegin(node); it != snapshot.successorsEnd(node); ++it) {
+                std::atomic<uint32_t>& count = released[*it];
+                if (cancelled) {
+                    count.fetch_or(SNAPSHOT_SKIP, std::memory_order_relaxed);
+                }
+                // the skip bit of an earlier release is seen by the last one
+                uint32_t seen = count.fetch_add(1, std::memory_order_acq_rel) + 1;
+                if ((seen & ~SNAPSHOT_SKIP) == snapshot.node(*it).in_degree) {
+                    scheduler.spawnSnapshotNode(*this, *it, (seen & SNAPSHOT_SKIP) != 0);
+                }
             }
+            scheduler.onTaskFinished(task);
         }
+    };
+    static constexpr uint32_t SNAPSHOT_SKIP = 1u << 31;
 
-        for (Task* task : rdy_tasks) {
-            pool_.submit(task);
+    // node of a snapshot run whose dependencies all finished: it gets a task only now
+    // (no completion callback or rank unless CRITICAL_PATH needs it, so nothing else is allocated)
+    void spawnSnapshotNode(SnapshotRun& run, uint32_t node, bool skipped) {
+        const SnapshotNode& entry = run.snapshot.node(node);
+        Task* task = createTask(node, [&run, node]() {
+            run.registry.call(run.snapshot.node(node).kernel, run.snapshot.params(node));
+        });
+        task->setPriority(static_cast<TaskPriority>(entry.priority));
+        if (policy_ == SchedulingPolicy::CRITICAL_PATH) {
+            task->setRank(entry.rank);
+        }
+        task->setGroup(&run.finished);
+        if (skipped) {
+            task->cancel();
+        }
+        // admitted like submit(): the roots wait on run()'s caller, successors are spawned
+        // on workers and forced in; either way admit() cannot fail without a deadline, and
+        // onTaskFinished hands back the same footprint
+        admit(1, footprint(task));
+        enqueue(task, &run);
+    }
+
+    // value task waiting for inputs, referenced by us and by the handle the caller returns
+    template <typename R, typename F, typename... Inputs>
+    Task* createValueTask(F&& fn, Inputs&&... inputs) {
+        Task* task = task_pool_.create(pool_.currentWorker(), nextId(), TaskWork());
+        std::array<Task*, sizeof...(Inputs)> taken = {takeInput(std::forward<Inputs>(inputs))...};
+        for (Task* input : taken) {
+            task->addDependency(input);
         }
+        task->setWork(ValueWork<R, std::decay_t<F>, Inputs...>(task, std::forward<F>(fn), taken));
+        task->retain(2);
+        return task;
     }
 
 public:
@@ -49,52 +321,324 @@ public:
     TaskScheduler& operator=(const TaskScheduler&) = delete;
     
     // Constructor
-    explicit TaskScheduler(size_t num_threads) 
-        : pool_(num_threads)
+    explicit TaskScheduler(size_t num_threads, PoolMode mode = PoolMode::WORK_STEALING)
+        : task_pool_(num_threads),
+          pool_(num_threads, mode)
     {
         // TODO: Body falls nötig
     }
+
+    // pinned / NUMA-aware workers, see ThreadPoolOptions
+    TaskScheduler(size_t num_threads, const ThreadPoolOptions& options)
+        : task_pool_(num_threads),
+          pool_(num_threads, options)
+    {}
     
-    // Destructor
+    // Destructor (drains the tasks; failures are not rethrown here)
     ~TaskScheduler() {
-        waitAll();
+        outstanding_.wait();
     }
     
-    // Submit Task (erkennt Dependencies automatisch)
+    // Getters (see ThreadPool)
+    size_t getNumThreads() const {
+        return pool_.getNumThreads();
+    }
+    int currentWorker() const {
+        return pool_.currentWorker();
+    }
+    size_t localBacklog() const {
+        return pool_.localBacklog();
+    }
+    BlockingLane* getBlockingLane() {
+        return pool_.getBlockingLane();
+    }
+
+    // see ThreadPool::setStatsEnabled / getStats
+    void setStatsEnabled(bool enabled) {
+        pool_.setStatsEnabled(enabled);
+    }
+    SchedulerStats getStats() const {
+        return pool_.getStats();
+    }
+
+    // see ThreadPool::setTracing / getTrace / writeChromeTrace (export after waitAll())
+    void setTracing(bool enabled) {
+        pool_.setTracing(enabled);
+    }
+    TraceRecorder* getTrace() {
+        return pool_.getTrace();
+    }
+    bool writeChromeTrace(const std::string& path) const {
+        return pool_.writeChromeTrace(path);
+    }
+
+    // see ThreadPool::setAgingLimit
+    void setAgingLimit(size_t picks) {
+        pool_.setAgingLimit(picks);
+    }
+
+    // Setter (policy, change it only while no tasks are in flight).
+    // CRITICAL_PATH orders ready tasks by Task::getRank() (see computeUpwardRanks)
+    // within each priority class; the classes are still served as in FIFO mode.
+    void setSchedulingPolicy(SchedulingPolicy policy) {
+        policy_ = policy;
+    }
+    SchedulingPolicy getSchedulingPolicy() const {
+        return policy_;
+    }
+
+    // Setter (what happens to the dependents of a task that threw, change it only while
+    // no tasks are in flight)
+    void setFailurePolicy(FailurePolicy policy) {
+        failure_policy_ = policy;
+    }
+    FailurePolicy getFailurePolicy() const {
+        return failure_policy_;
+    }
+
+    // Setter (admission control, change it only while no tasks are in flight). At the limit
+    // submit() and submitBatch() block, trySubmit() fails or waits up to its timeout, and
+    // blocked producers are let in in arrival order as tasks finish. Tasks count from
+    // submission until they finished, including those still waiting for dependencies:
+    // a producer must not block on tasks that only its own later submissions can release.
+    void setAdmissionLimits(const AdmissionLimits& limits) {
+        admission_.setLimits(limits);
+    }
+    // tasks / bytes held and producers waiting
+    const AdmissionControl& getAdmission() const {
+        return admission_;
+    }
+
+    // every failure reported by the calling thread's last waitAll() / wait() / run() that threw
+    std::vector<TaskError> getErrors() {
+        std::lock_guard<std::mutex> lock(errors_mutex_);
+        auto it = reported_.find(threadShard());
+        return it != reported_.end() ? it->second : std::vector<TaskError>();
+    }
+
+    // Create Task from the scheduler's slab pool.
+    // Wire its dependencies before submitting it: once submitted, the task is
+    // recycled after it finished and the pointer must not be used anymore.
+    Task* createTask(uint64_t id, TaskWork work) {
+        return task_pool_.create(pool_.currentWorker(), id, std::move(work));
+    }
+
+    // The submit functions may be called from any number of threads at once: tasks are
+    // registered in sharded lock-free lists and enter the pool through lock-free queues.
+    // With admission limits set they block until there is room (see setAdmissionLimits).
+
+    // Submit Task (erkennt Dependencies automatisch). The scheduler owns it from here on: it
+    // is freed by the next waitAll() of the submitting thread once it finished, so a raw
+    // pointer to it (e.g. for addDependency) is only valid until that thread waits.
+    // Tasks of a thread that never waits (e.g. a running task) live until the scheduler is destroyed.
     void submit(std::unique_ptr<Task> task) {
-        Task* raw_task = task.get();
+        submit(owned_tasks_.add(std::move(task), submittingThread()));
+    }
+
+    // Submit Task from createTask()
+    void submit(Task* task) {
+        admit(1, footprint(task));
+        enqueue(task);
+    }
 
-        owned_tasks_.push_back(std::move(task));
-        all_tasks_.push_back(raw_task);
+    // Submit unless the admission limit is reached; waits up to timeout for room first.
+    // On false nothing was submitted and the caller still owns the task.
+    bool trySubmit(Task* task, std::chrono::steady_clock::duration timeout = {}) {
+        if (!admit(1, footprint(task), deadlineAfter(timeout))) {
+            return false;
+        }
+        enqueue(task);
+        return true;
+    }
+    bool trySubmit(std::unique_ptr<Task>&& task, std::chrono::steady_clock::duration timeout = {}) {
+        if (!admit(1, footprint(task.get()), deadlineAfter(timeout))) {
+            return false;
+        }
+        enqueue(owned_tasks_.add(std::move(task), submittingThread()));
+        return true;
+    }
 
-        raw_task->setOnCompleteCallback([this](Task* t){
-            this->onTaskCompleted(t);
-        });
+    // Submit Task and track it in group as well (group.wait() only waits for its own tasks)
+    void submit(std::unique_ptr<Task> task, TaskGroup& group) {
+        group.add();
+        task->setGroup(&group);
+        submit(std::move(task));
+    }
+    void submit(Task* task, TaskGroup& group) {
+        group.add();
+        task->setGroup(&group);
+        submit(task);
+    }
 
-        if (raw_task->isReady()) {
-            pool_.submit(raw_task);
-        } else {
-            std::lock_guard<std::mutex> lock(pending_mutex_);
-            pending_tasks_.push_back(raw_task);
+    // Submit count tasks from createTask() at once (dependencies wired already):
+    // one counter update and a wakeup sized to the ready tasks
+    void submitBatch(Task* const* tasks, size_t count) {
+        if (admission_.limited()) {
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; ++i) {
+                bytes += footprint(tasks[i]);
+            }
+            admit(count, bytes);
         }
+        outstanding_.add(count);
+
+        size_t thread = submittingThread();
+        std::vector<Task*> ready;
+        ready.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            setSubmitter(tasks[i], thread);
+            if (Task* entry = attach(tasks[i])) {
+                ready.push_back(entry);
+            }
+        }
+        pool_.submitBatch(ready.data(), ready.size());
+    }
+    void submitBatch(const std::vector<Task*>& tasks) {
+        submitBatch(tasks.data(), tasks.size());
     }
-    
-    // Warte bis alle Tasks fertig sind
-    void waitAll() {
-        while (true) {
-            bool all_completed = true;
 
-            for (Task* task : all_tasks_) {
-                if (task->getState() != TaskState::COMPLETED) {
-                    all_completed = false;
-                    break;
-                }
+    // Submit owned tasks at once (freed at the submitting thread's next waitAll(), see submit)
+    void submitBatch(std::vector<std::unique_ptr<Task>> tasks) {
+        std::vector<Task*> raw_tasks;
+        raw_tasks.reserve(tasks.size());
+        for (auto& task : tasks) {
+            raw_tasks.push_back(task.get());
+        }
+        owned_tasks_.add(tasks, submittingThread());
+        submitBatch(raw_tasks);
+    }
+
+    // Submit a pre-wired DAG; under CRITICAL_PATH its ranks are computed first
+    void submitGraph(const std::vector<Task*>& tasks) {
+        if (policy_ == SchedulingPolicy::CRITICAL_PATH) {
+            computeUpwardRanks(tasks);
+        }
+        submitBatch(tasks);
+    }
+    void submitGraph(std::vector<std::unique_ptr<Task>> tasks) {
+        if (policy_ == SchedulingPolicy::CRITICAL_PATH) {
+            std::vector<Task*> raw_tasks;
+            raw_tasks.reserve(tasks.size());
+            for (auto& task : tasks) {
+                raw_tasks.push_back(task.get());
+            }
+            computeUpwardRanks(raw_tasks);
+        }
+        submitBatch(std::move(tasks));
+    }
+
+    // Runs a TaskGraph (frozen here if needed) and waits until all of its tasks finished.
+    // A replay only re-arms the counters: no allocation and no dependency wiring.
+    // Returns false if the graph has a cycle. Do not run one graph twice at the same time.
+    // Rethrows like waitAll() if a task failed.
+    bool run(TaskGraph& graph) {
+        if (!graph.freeze()) {
+            return false;
+        }
+        size_t count = graph.size();
+        if (admission_.limited()) {
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; ++i) {
+                bytes += footprint(graph.tasks_[i]);
             }
+            admit(count, bytes);
+        }
+        graph.rearm();
+        outstanding_.add(count);
 
-            if (all_completed) {return;}
+        graph.ready_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (Task* entry = attach(graph.tasks_[i])) {
+                graph.ready_.push_back(entry);
+            }
+        }
+        pool_.submitBatch(graph.ready_.data(), graph.ready_.size());
+        graph.finished_.wait();
+        rethrowErrors(&graph.finished_);
+        return true;
+    }
 
-            std::this_thread::yield(); 
+    // Runs a mapped GraphSnapshot with the kernels of registry and waits until all of its
+    // nodes finished. Nothing is built up front: a node takes a task from the pool when its
+    // last dependency finished (the roots right away), so the first kernel starts at once
+    // whatever the size of the graph. Failures and cancellation propagate as in run(graph);
+    // a kernel id missing from registry fails its node. Rethrows like waitAll().
+    void run(const GraphSnapshot& snapshot, KernelRegistry& registry) {
+        SnapshotRun run(*this, snapshot, registry);
+        run.finished.add(snapshot.size());
+        for (size_t i = 0; i < snapshot.numRoots(); ++i) {
+            spawnSnapshotNode(run, snapshot.roots()[i], false);
+        }
+        run.finished.wait();
+        rethrowErrors(&run.finished);
+    }
+
+    // Submit work directly: the task is built in place in the pool (ids are assigned here)
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<std::decay_t<F>&> &&
+                                                      std::is_void_v<std::invoke_result_t<std::decay_t<F>&>>>>
+    void submit(F&& work) {
+        submit(task_pool_.create(pool_.currentWorker(), nextId(), std::forward<F>(work)));
+    }
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<std::decay_t<F>&>>>
+    void submit(F&& work, TaskGroup& group) {
+        submit(task_pool_.create(pool_.currentWorker(), nextId(), std::forward<F>(work)), group);
+    }
+    // work is only consumed if it was submitted
+    template <typename F, typename = std::enable_if_t<std::is_invocable_v<std::decay_t<F>&>>>
+    bool trySubmit(F&& work, std::chrono::steady_clock::duration timeout = {}) {
+        if (!admit(1, sizeof(Task), deadlineAfter(timeout))) {
+            return false;
         }
+        enqueue(task_pool_.create(pool_.currentWorker(), nextId(), std::forward<F>(work)));
+        return true;
+    }
+
+    // Submit a value task: fn's return value is kept inside the task's slot, and inputs are
+    // results of earlier submissions that fn receives as arguments (in order, void ones
+    // skipped). A handle passed as lvalue gives fn a const reference to the value, one passed
+    // as rvalue moves the value in (the caller promises it is the last reader). The task
+    // waits for its inputs; every result lives until its last handle and consumer let go.
+    template <typename F, typename... Inputs,
+              typename = std::enable_if_t<(IsTaskResult<std::decay_t<Inputs>>::value && ...)>,
+              typename = std::enable_if_t<is_value_invocable<F, Inputs...>>,
+              typename R = ValueResult<F, Inputs...>,
+              typename = std::enable_if_t<sizeof...(Inputs) != 0 || !std::is_void_v<R>>>
+    TaskResult<R> submit(F&& fn, Inputs&&... inputs) {
+        Task* task = createValueTask<R>(std::forward<F>(fn), std::forward<Inputs>(inputs)...);
+        submit(task);
+        return TaskResult<R>(task);
+    }
+
+    // Like submit(fn, inputs...) for work that blocks (file reads, network): the task runs
+    // in the pool's BlockingLane instead of on a CPU worker, its consumers on the workers.
+    template <typename F, typename... Inputs,
+              typename = std::enable_if_t<(IsTaskResult<std::decay_t<Inputs>>::value && ...)>,
+              typename = std::enable_if_t<is_value_invocable<F, Inputs...>>,
+              typename R = ValueResult<F, Inputs...>>
+    TaskResult<R> submitBlocking(F&& fn, Inputs&&... inputs) {
+        Task* task = createValueTask<R>(std::forward<F>(fn), std::forward<Inputs>(inputs)...);
+        task->setBlocking(true);
+        submit(task);
+        return TaskResult<R>(task);
+    }
+
+    // Warte bis alle Tasks fertig sind (blocks without spinning).
+    // Finished tasks this thread submitted as unique_ptr are freed here (those of other
+    // threads are left to their own waits). If tasks threw since the last wait,
+    // the first exception is rethrown and all of them are listed by getErrors(). Only failures
+    // of tasks this thread submitted (or tasks submitted from inside the pool) are reported
+    // here; those of graphs and snapshots go to their run(), other threads' to their waits.
+    void waitAll() {
+        outstanding_.wait();
+        owned_tasks_.release();
+        rethrowErrors(nullptr);
+    }
+
+    // Waits for the tasks submitted with group (like group.wait()) and rethrows the first
+    // failure among them that no waitAll() reported yet
+    void wait(TaskGroup& group) {
+        group.wait();
+        rethrowErrors(&group);
     }
 
 
@@ -1,43 +1,693 @@
 //src/thread_pool.h
 #pragma once
 
+#include "blocking_lane.h"
+#include "cache_line.h"
+#include "mpmc_queue.h"
+#include "scheduler_stats.h"
 #include "task.h"
+#include "topology.h"
+#include "trace_recorder.h"
+#include "work_stealing_deque.h"
 #include <vector>
 #include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <random>
+#include <string>
 
 
+enum class PoolMode {
+    SHARED_QUEUE,   // one mutex-guarded FIFO per priority for all workers
+    WORK_STEALING    // per-worker Chase-Lev deques + injection queue (per priority)
+};
+
+// What a worker does when it runs out of work: poll spin_rounds times with a short
+// pause in between, then yield_rounds times with a yield, then park.
+// Spinning workers pick up new work without a wakeup syscall; the budget bounds the CPU they burn.
+struct IdlePolicy {
+    size_t spin_rounds = 64;
+    size_t yield_rounds = 16;
+
+    static IdlePolicy park() {
+        return IdlePolicy{0, 0};
+    }
+    static IdlePolicy spinThenPark(size_t spin_rounds = 64, size_t yield_rounds = 16) {
+        return IdlePolicy{spin_rounds, yield_rounds};
+    }
+};
+
+// Worker placement and idling. By default workers are not pinned and the pool behaves as one node.
+struct ThreadPoolOptions {
+    PoolMode mode = PoolMode::WORK_STEALING;
+    bool pin_workers = false; // pin every worker to one cpu, one set of injection queues per NUMA node
+    std::vector<int> cpus;    // worker i runs on cpus[i % size]; empty = dealt over the Topology nodes
+    IdlePolicy idle;
+    bool collect_stats = false; // per-worker counters and latency histograms, see getStats()
+    uint32_t stats_sample_period = 16; // time one in this many tasks (counters are always exact)
+    size_t trace_events = 0; // ring buffer size per worker for tracing (0 = no tracing), see setTracing()
+    size_t injection_capacity = 4096; // lock-free injection queue per node and class (work-stealing mode)
+    size_t blocking_threads = 64; // upper bound of the elastic lane for blocking tasks (0 = run them on the workers)
+    std::chrono::milliseconds blocking_keep_alive{1000}; // idle lane threads exit after this
+};
+
+// spin-wait hint for the cpu (pause on x86)
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Anti-starvation for priority classes: every pick ages all less important
+// classes by one, and a class whose age reached the limit is tried first.
+// A waiting LOW task is therefore served at least once per aging_limit picks.
+struct PriorityAging {
+    size_t age[NUM_PRIORITIES] = {};
+
+    // order in which the classes are tried for the next pick
+    void order(size_t aging_limit, size_t (&classes)[NUM_PRIORITIES]) const {
+        size_t first = 0;
+        for (size_t p = NUM_PRIORITIES - 1; p > 0; --p) {
+            if (aging_limit > 0 && age[p] >= aging_limit) {
+                first = p;
+                break;
+            }
+        }
+        classes[0] = first;
+        size_t next = 1;
+        for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+            if (p != first) {
+                classes[next++] = p;
+            }
+        }
+    }
+
+    void served(size_t priority) {
+        age[priority] = 0;
+        for (size_t p = priority + 1; p < NUM_PRIORITIES; ++p) {
+            ++age[p];
+        }
+    }
+};
+
 class ThreadPool {
 private:
+    // per-worker ready deques, one per priority class
+    struct LocalQueues {
+        WorkStealingDeque<Task> deques[NUM_PRIORITIES];
+    };
+
+    // queues of one NUMA node, written on every external submit.
+    // Work-stealing mode injects through lock-free MPMC rings; only when a ring is full do
+    // tasks go to the locked queue behind it (and keep going there until it drained, so
+    // the order stays FIFO). Shared-queue mode only uses node 0's locked queues, guarded
+    // by queue_mutex_ instead of mutex.
+    struct alignas(CACHE_LINE_SIZE) NodeQueues {
+        std::mutex mutex;
+        std::queue<Task*> queues[NUM_PRIORITIES];
+        std::atomic<size_t> injected[NUM_PRIORITIES] = {}; // sizes of queues, readable without the lock
+        std::unique_ptr<MpmcQueue<Task>> rings[NUM_PRIORITIES]; // work-stealing mode
+
+        // tasks of a class in this node's queues (approximate while they change)
+        size_t queued(size_t priority) const {
+            size_t count = injected[priority].load(std::memory_order_acquire);
+            if (rings[priority]) {
+                count += rings[priority]->size();
+            }
+            return count;
+        }
+    };
+
+    // read-mostly
     size_t num_threads_;
+    PoolMode mode_;
     std::atomic<bool> stop_;
-    std::mutex queue_mutex_;
-    std::condition_variable condition_;
-    std::queue<Task*> task_queue_;
+    std::atomic<size_t> aging_limit_{16};
     std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<LocalQueues>> local_queues_; // work-stealing mode only
+    std::vector<std::unique_ptr<NodeQueues>> node_queues_;
+    std::vector<int> worker_cpu_;                 // -1 = not pinned
+    std::vector<size_t> worker_node_;             // index into node_queues_
+    std::vector<std::vector<size_t>> node_workers_;
+    Topology topology_;
+    IdlePolicy idle_policy_;
+    std::atomic<bool> collect_stats_;
+    uint32_t stats_sample_period_;
+    std::vector<std::unique_ptr<WorkerStats>> worker_stats_; // one per worker, then one for outside threads
+    std::unique_ptr<TraceRecorder> trace_;   // null unless ThreadPoolOptions::trace_events was set
+    std::atomic<bool> tracing_{false};
+    std::unique_ptr<BlockingLane> blocking_; // null if ThreadPoolOptions::blocking_threads is 0
+
+    // parking, kept away from the read-mostly fields above
+    alignas(CACHE_LINE_SIZE) std::mutex queue_mutex_;
+    std::condition_variable condition_;
+    PriorityAging shared_aging_;           // shared-queue mode, guarded by queue_mutex_
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> num_sleeping_{0};  // workers parked on condition_
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> num_spinning_{0}; // idle workers still polling for work
+
+    // identifies the pool and the index of the worker running on this thread
+    static inline thread_local ThreadPool* current_pool_ = nullptr;
+    static inline thread_local size_t current_index_ = 0;
+    static inline thread_local uint32_t stats_tick_ = 0; // submissions since the last timed one
+
+    static size_t priorityIndex(const Task* task) {
+        return static_cast<size_t>(task->getPriority());
+    }
+
+    bool statsEnabled() const {
+#if TASK_SCHEDULER_STATS
+        return collect_stats_.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    bool tracingEnabled() const {
+#if TASK_SCHEDULER_TRACE
+        return tracing_.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
 
-    void workerLoop(){
+    // records into the trace buffer of worker index
+    void trace(size_t index, TraceEventType type, uint64_t task_id) {
+        trace_->buffer(index).record(type, task_id);
+    }
+
+    // a worker made task runnable: drawn as an arrow to the task's start
+    void traceReady(const Task* task) {
+        if (tracingEnabled() && current_pool_ == this) {
+            trace(current_index_, TraceEventType::READY, task->getId());
+        }
+    }
+
+    // statistics of the calling thread (threads outside the pool share the last slot)
+    WorkerStats& callerStats() {
+        return *worker_stats_[current_pool_ == this ? current_index_ : num_threads_];
+    }
+
+    // takes a queue lock; while stats are collected, acquisitions and contention are counted
+    std::unique_lock<std::mutex> lockQueue(std::mutex& mutex) {
+        if (!statsEnabled()) {
+            return std::unique_lock<std::mutex>(mutex);
+        }
+        WorkerStats& stats = callerStats();
+        stats.add(StatCounter::LOCK_ACQUISITIONS);
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            uint64_t start = statsClockNs();
+            lock.lock();
+            stats.add(StatCounter::LOCK_CONTENDED);
+            stats.lock_wait.record(statsClockNs() - start, stats.shared);
+        }
+        return lock;
+    }
+
+    // Reading the clock costs about as much as a short task, so only every
+    // stats_sample_period_-th submission is stamped; the worker times stamped tasks only.
+    bool sampleSubmission() {
+        if (++stats_tick_ < stats_sample_period_) {
+            return false;
+        }
+        stats_tick_ = 0;
+        return true;
+    }
+
+    // runs task on worker index, traced if tracing is on
+    void runTask(size_t index, Task* task) {
+        if (task->isForwarding()) {
+            task->execute(); // accounted for as the task it runs (runForwarded)
+            return;
+        }
+        if (!tracingEnabled()) {
+            executeCounted(index, task);
+            return;
+        }
+        // the id is read first: the task may be recycled by the time it finished
+        uint64_t id = task->getId();
+        trace(index, TraceEventType::TASK_START, id);
+        executeCounted(index, task);
+        trace(index, TraceEventType::TASK_END, id);
+    }
+
+    // runs task on worker index (counted, and timed if it was stamped, while stats are collected)
+    void executeCounted(size_t index, Task* task) {
+        if (!statsEnabled()) {
+            task->execute();
+            return;
+        }
+        WorkerStats& stats = *worker_stats_[index];
+        stats.add(StatCounter::TASKS_EXECUTED);
+        // read before execute(): the task may be recycled by then
+        uint64_t ready = task->getReadyTime();
+        if (ready == 0) {
+            task->execute();
+            return;
+        }
+        uint64_t start = statsClockNs();
+        if (ready <= start) {
+            stats.queue_wait.record(start - ready);
+        }
+        task->execute();
+        uint64_t run_time = statsClockNs() - start;
+        stats.run_time.record(run_time);
+        stats.add(StatCounter::BUSY_NS, run_time * stats_sample_period_);
+    }
+
+    // idle period that started at since (0 = none) is over
+    void endIdle(size_t index, uint64_t& since) {
+        if (since != 0) {
+            worker_stats_[index]->add(StatCounter::IDLE_NS, statsClockNs() - since);
+            since = 0;
+        }
+    }
+
+    bool anyInjected() const {
+        for (const auto& node : node_queues_) {
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                if (node->queued(p) > 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // shared-queue mode, called with queue_mutex_ held
+    Task* popQueued(PriorityAging& aging) {
+        NodeQueues& node = *node_queues_[0];
+        size_t classes[NUM_PRIORITIES];
+        aging.order(aging_limit_.load(std::memory_order_relaxed), classes);
+        for (size_t p : classes) {
+            if (!node.queues[p].empty()) {
+                Task* task = node.queues[p].front();
+                node.queues[p].pop();
+                node.injected[p].fetch_sub(1, std::memory_order_relaxed);
+                aging.served(p);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    // shared-queue mode, called with queue_mutex_ held: tasks waiting in the queues
+    size_t sharedQueued() const {
+        size_t count = 0;
+        for (const auto& queue : node_queues_[0]->queues) {
+            count += queue.size();
+        }
+        return count;
+    }
+
+    // Shared-queue mode: wake up to count parked workers after pushing tasks, with queued
+    // tasks in the queues. Each spinning worker takes one of them, so only the queued tasks
+    // beyond the spinners need a parked worker (a burst of single submits against one
+    // spinner keeps waking workers from the second task on).
+    void wakeShared(size_t queued, size_t count) {
+        size_t spinning = num_spinning_.load(std::memory_order_seq_cst);
+        if (queued <= spinning) {
+            return;
+        }
+        count = std::min(count, queued - spinning);
+        if (count >= num_threads_) {
+            condition_.notify_all();
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                condition_.notify_one();
+            }
+        }
+    }
+
+    void workerLoop(size_t index){
+        enterWorker(index);
+        uint64_t idle_since = 0; // stats: when the worker ran out of work
         while (true) {
             Task* task = nullptr; // if no task is available
 
+            if (!anyInjected()) {
+                if (statsEnabled() && idle_since == 0) {
+                    idle_since = statsClockNs();
+                }
+                if (spinIdle([this]() { return anyInjected(); }) && statsEnabled()) {
+                    worker_stats_[index]->add(StatCounter::SPIN_HITS);
+                }
+            }
+
             { // lock queue (unique) and wait for task
-                std::unique_lock<std::mutex> lock(queue_mutex_);
-                condition_.wait(lock, [this]{ 
-                    return stop_.load(std::memory_order_acquire) || !task_queue_.empty();
+                std::unique_lock<std::mutex> lock = lockQueue(queue_mutex_);
+                num_sleeping_.fetch_add(1, std::memory_order_relaxed);
+                bool parks = !anyInjected() && !stop_.load(std::memory_order_relaxed);
+                if (parks && statsEnabled()) {
+                    worker_stats_[index]->add(StatCounter::PARKS);
+                }
+                bool traced = parks && tracingEnabled();
+                if (traced) {
+                    trace(index, TraceEventType::PARK, 0);
+                }
+                condition_.wait(lock, [this]{
+                    return stop_.load(std::memory_order_acquire) || anyInjected();
                 });
+                if (traced) {
+                    trace(index, TraceEventType::UNPARK, 0);
+                }
+                num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
                 // end if no task left after stop signal
-                if (stop_.load(std::memory_order_acquire) && task_queue_.empty()) {
+                if (stop_.load(std::memory_order_acquire) && !anyInjected()) {
                     return;
                 }
-                // else get next  task
-                task = task_queue_.front();
-                task_queue_.pop();
+                // else get next task (most important class, unless a lower class aged out)
+                task = popQueued(shared_aging_);
             } // lock release here
             if (task) {
-                task->execute();
+                if (statsEnabled()) {
+                    worker_stats_[index]->add(StatCounter::INJECTED_POPS);
+                }
+                endIdle(index, idle_since);
+                runTask(index, task);
+            }
+        }
+    }
+
+    static ThreadPoolOptions optionsFor(PoolMode mode) {
+        ThreadPoolOptions options;
+        options.mode = mode;
+        return options;
+    }
+
+    // registers the calling thread as worker index and pins it if requested
+    void enterWorker(size_t index) {
+        current_pool_ = this;
+        current_index_ = index;
+        if (worker_cpu_[index] >= 0) {
+            pinCurrentThread(worker_cpu_[index]);
+        }
+    }
+
+    // node of the submitting thread
+    size_t submitterNode() const {
+        if (node_queues_.size() == 1) {
+            return 0;
+        }
+        if (current_pool_ == this) {
+            return worker_node_[current_index_];
+        }
+        int cpu = currentCpu();
+        return cpu >= 0 ? topology_.nodeOfCpu(cpu) : 0;
+    }
+
+    // node whose queues receive task: its hint if it has one, else the submitter's node
+    size_t targetNode(const Task* task, size_t submitter) const {
+        int hint = task->getNumaNode();
+        if (hint >= 0) {
+            return static_cast<size_t>(hint) % node_queues_.size();
+        }
+        return submitter;
+    }
+
+    // work-stealing mode: any thread, lock-free unless the ring is full; callers wake a worker afterwards
+    void pushInjected(size_t node_index, size_t priority, Task* task) {
+        NodeQueues& node = *node_queues_[node_index];
+        if (node.injected[priority].load(std::memory_order_acquire) == 0 && node.rings[priority]->push(task)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock = lockQueue(node.mutex);
+        node.queues[priority].push(task);
+        node.injected[priority].fetch_add(1, std::memory_order_release);
+    }
+
+    // work-stealing mode, any thread: injects a batch with one ring reservation per class
+    // and node; what does not fit goes to the node's locked queues under a single lock.
+    // The tasks are sorted into their (node, class) buckets before the first push: a pushed
+    // task may run and be recycled while the rest of the batch is still going out.
+    void pushInjectedBatch(Task* const* tasks, size_t count, size_t submitter) {
+        std::vector<size_t> keys(count); // node * NUM_PRIORITIES + class
+        std::vector<size_t> begin(node_queues_.size() * NUM_PRIORITIES + 1, 0);
+        for (size_t i = 0; i < count; ++i) {
+            keys[i] = targetNode(tasks[i], submitter) * NUM_PRIORITIES + priorityIndex(tasks[i]);
+            ++begin[keys[i] + 1];
+        }
+        for (size_t b = 1; b < begin.size(); ++b) {
+            begin[b] += begin[b - 1];
+        }
+        std::vector<Task*> sorted(count); // by bucket, in submission order within one
+        std::vector<size_t> fill(begin.begin(), begin.end() - 1);
+        for (size_t i = 0; i < count; ++i) {
+            sorted[fill[keys[i]]++] = tasks[i];
+        }
+
+        for (size_t n = 0; n < node_queues_.size(); ++n) {
+            NodeQueues& node = *node_queues_[n];
+            const size_t* bucket = begin.data() + n * NUM_PRIORITIES;
+            size_t pushed[NUM_PRIORITIES] = {};
+            bool overflow = false;
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                size_t added = bucket[p + 1] - bucket[p];
+                if (added > 0 && node.injected[p].load(std::memory_order_acquire) == 0) {
+                    pushed[p] = node.rings[p]->pushBulk(sorted.data() + bucket[p], added);
+                }
+                overflow |= pushed[p] < added;
+            }
+            if (!overflow) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock = lockQueue(node.mutex);
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                size_t rest = bucket[p + 1] - bucket[p] - pushed[p];
+                for (size_t i = bucket[p] + pushed[p]; i < bucket[p + 1]; ++i) {
+                    node.queues[p].push(sorted[i]);
+                }
+                if (rest > 0) {
+                    node.injected[p].fetch_add(rest, std::memory_order_release);
+                }
+            }
+        }
+    }
+
+    // pop from the injection queue of one node and class without blocking (ring first: older tasks)
+    Task* popInjected(size_t node_index, size_t priority) {
+        NodeQueues& node = *node_queues_[node_index];
+        if (Task* task = node.rings[priority]->pop()) {
+            return task;
+        }
+        if (node.injected[priority].load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lock = lockQueue(node.mutex);
+        if (node.queues[priority].empty()) {
+            return nullptr;
+        }
+        Task* task = node.queues[priority].front();
+        node.queues[priority].pop();
+        node.injected[priority].fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    // steal one task of a class from victims, starting at a random one
+    Task* stealFrom(const std::vector<size_t>& victims, size_t index, size_t priority, std::minstd_rand& rng) {
+        if (victims.empty()) {
+            return nullptr;
+        }
+        size_t start = rng() % victims.size();
+        for (size_t i = 0; i < victims.size(); ++i) {
+            size_t victim = victims[(start + i) % victims.size()];
+            if (victim != index) {
+                if (Task* task = local_queues_[victim]->deques[priority].steal()) {
+                    return task;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // per class: local deque, own node (injection queue, then stealing), then the remote nodes
+    Task* findTask(size_t index, std::minstd_rand& rng, PriorityAging& aging) {
+        size_t classes[NUM_PRIORITIES];
+        aging.order(aging_limit_.load(std::memory_order_relaxed), classes);
+        size_t home = worker_node_[index];
+
+        for (size_t p : classes) {
+            StatCounter source = StatCounter::LOCAL_POPS;
+            Task* task = local_queues_[index]->deques[p].pop();
+            if (!task) {
+                task = popInjected(home, p);
+                source = StatCounter::INJECTED_POPS;
+            }
+            if (!task) {
+                task = stealFrom(node_workers_[home], index, p, rng);
+                source = StatCounter::STEALS;
+            }
+            for (size_t i = 1; i < node_queues_.size() && !task; ++i) {
+                size_t node = (home + i) % node_queues_.size();
+                task = popInjected(node, p);
+                source = StatCounter::INJECTED_POPS;
+                if (!task) {
+                    task = stealFrom(node_workers_[node], index, p, rng);
+                    source = StatCounter::STEALS;
+                }
+            }
+            if (task) {
+                aging.served(p);
+                if (statsEnabled()) {
+                    worker_stats_[index]->add(source);
+                }
+                if (source == StatCounter::STEALS && tracingEnabled()) {
+                    trace(index, TraceEventType::STEAL, task->getId());
+                }
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    // exact when called with queue_mutex_ held by a worker about to park
+    bool hasVisibleWork() const {
+        if (anyInjected()) {
+            return true;
+        }
+        for (const auto& queues : local_queues_) {
+            for (const auto& deque : queues->deques) {
+                if (!deque.empty()) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // work-stealing mode: tasks in the injection queues and local deques (approximate while they change)
+    size_t visibleBacklog() const {
+        size_t count = 0;
+        for (const auto& node : node_queues_) {
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                count += node->queued(p);
+            }
+        }
+        for (const auto& queues : local_queues_) {
+            for (const auto& deque : queues->deques) {
+                count += static_cast<size_t>(std::max<int64_t>(0, deque.size()));
+            }
+        }
+        return count;
+    }
+
+    // Idle phase before parking: polls until poll() succeeds or the IdlePolicy budget is spent.
+    // While registered as spinning, submitters leave one task per spinner to the spinners
+    // (wake, wakeShared); the last spinner that finds work passes the wakeup on if more
+    // work is visible.
+    template <typename Poll>
+    bool spinIdle(Poll&& poll) {
+        size_t rounds = idle_policy_.spin_rounds + idle_policy_.yield_rounds;
+        if (rounds == 0) {
+            return false;
+        }
+        num_spinning_.fetch_add(1, std::memory_order_seq_cst);
+        bool found = false;
+        for (size_t round = 0; round < rounds && !found; ++round) {
+            if (stop_.load(std::memory_order_relaxed)) {
+                break;
+            }
+            if (round < idle_policy_.spin_rounds) {
+                for (int i = 0; i < 32; ++i) {
+                    cpuRelax();
+                }
+            } else {
+                std::this_thread::yield();
+            }
+            found = poll();
+        }
+        if (num_spinning_.fetch_sub(1, std::memory_order_seq_cst) == 1 && found && hasVisibleWork()) {
+            wake(1);
+        }
+        return found;
+    }
+
+    void stealingLoop(size_t index) {
+        enterWorker(index);
+        std::minstd_rand rng(static_cast<unsigned>(index + 1));
+        PriorityAging aging;
+        uint64_t idle_since = 0; // stats: when the worker ran out of work
+
+        while (true) {
+            Task* task = findTask(index, rng, aging);
+            if (!task) {
+                if (statsEnabled() && idle_since == 0) {
+                    idle_since = statsClockNs();
+                }
+                bool found = spinIdle([&]() {
+                    task = findTask(index, rng, aging);
+                    return task != nullptr;
+                });
+                if (found && statsEnabled()) {
+                    worker_stats_[index]->add(StatCounter::SPIN_HITS);
+                }
+            }
+            if (task) {
+                endIdle(index, idle_since);
+                runTask(index, task);
+                continue;
+            }
+
+            // nothing found -> park until new work is published
+            std::unique_lock<std::mutex> lock = lockQueue(queue_mutex_);
+            if (statsEnabled()) {
+                worker_stats_[index]->add(StatCounter::PARKS);
+            }
+            num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool traced = tracingEnabled();
+            if (traced) {
+                trace(index, TraceEventType::PARK, 0);
+            }
+            condition_.wait(lock, [this]{
+                return stop_.load(std::memory_order_acquire) || hasVisibleWork();
+            });
+            if (traced) {
+                trace(index, TraceEventType::UNPARK, 0);
+            }
+            num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            if (stop_.load(std::memory_order_acquire) && !hasVisibleWork()) {
+                return;
+            }
+        }
+    }
+
+    // Wake up to count parked workers after a lock-free push of count tasks. Each spinning
+    // worker takes one task, so with enough spinners only the visible backlog beyond them
+    // needs a parked worker (as in wakeShared: a burst of single submits against one
+    // spinner keeps waking workers from the second task on).
+    void wake(size_t count) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t sleeping = num_sleeping_.load(std::memory_order_relaxed);
+        if (sleeping == 0) {
+            return;
+        }
+        size_t spinning = num_spinning_.load(std::memory_order_relaxed);
+        if (spinning >= count) {
+            size_t backlog = visibleBacklog();
+            if (backlog <= spinning) {
+                return;
+            }
+            count = std::min(count, backlog - spinning);
+        } else {
+            count -= spinning;
+        }
+        // the lock orders us after a worker that is between its check and wait(); it guards
+        // no queue, so it is not counted as a queue lock (LOCK_ACQUISITIONS)
+        { std::lock_guard<std::mutex> lock(queue_mutex_); }
+        if (count >= sleeping) {
+            condition_.notify_all();
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                condition_.notify_one();
             }
         }
     }
@@ -48,18 +698,78 @@ public:
     ThreadPool& operator=(const ThreadPool&) = delete;
 
     //Constructor
-    explicit ThreadPool(size_t num_threads): 
-        num_threads_(num_threads) ,   
-        stop_(false) 
+    explicit ThreadPool(size_t num_threads, PoolMode mode = PoolMode::WORK_STEALING):
+        ThreadPool(num_threads, optionsFor(mode))
+    {}
+
+    ThreadPool(size_t num_threads, const ThreadPoolOptions& options):
+        num_threads_(num_threads) ,
+        mode_(options.mode),
+        stop_(false),
+        idle_policy_(options.idle),
+        collect_stats_(options.collect_stats),
+        stats_sample_period_(std::max<uint32_t>(1, options.stats_sample_period))
     {
+        for (size_t i = 0; i <= num_threads_; ++i) {
+            worker_stats_.push_back(std::make_unique<WorkerStats>());
+        }
+        worker_stats_.back()->shared = true;
+        if (options.trace_events > 0) {
+            trace_ = std::make_unique<TraceRecorder>(num_threads_, options.trace_events);
+            tracing_.store(true, std::memory_order_relaxed);
+        }
+        if (options.blocking_threads > 0) {
+            blocking_ = std::make_unique<BlockingLane>(options.blocking_threads, options.blocking_keep_alive);
+        }
+
+        // placement: cpu and node per worker (one node for unpinned workers or a shared queue)
+        size_t num_nodes = options.pin_workers && mode_ == PoolMode::WORK_STEALING ? topology_.numNodes() : 1;
+        for (size_t i = 0; i < num_threads_; ++i) {
+            int cpu = -1;
+            if (options.pin_workers) {
+                cpu = options.cpus.empty() ? topology_.cpuForWorker(i) : options.cpus[i % options.cpus.size()];
+            }
+            worker_cpu_.push_back(cpu);
+            worker_node_.push_back(num_nodes > 1 ? topology_.nodeOfCpu(cpu) : 0);
+        }
+        node_workers_.resize(num_nodes);
+        for (size_t n = 0; n < num_nodes; ++n) {
+            node_queues_.push_back(std::make_unique<NodeQueues>());
+            if (mode_ == PoolMode::WORK_STEALING) {
+                for (auto& ring : node_queues_.back()->rings) {
+                    ring = std::make_unique<MpmcQueue<Task>>(std::max<size_t>(2, options.injection_capacity));
+                }
+            }
+        }
         for (size_t i = 0; i < num_threads_; ++i) {
-            threads_.emplace_back([this]() {workerLoop(); });
+            node_workers_[worker_node_[i]].push_back(i);
+        }
+
+        if (mode_ == PoolMode::WORK_STEALING) {
+            for (size_t i = 0; i < num_threads_; ++i) {
+                local_queues_.push_back(std::make_unique<LocalQueues>());
+            }
+            for (size_t i = 0; i < num_threads_; ++i) {
+                threads_.emplace_back([this, i]() {stealingLoop(i); });
+            }
+        } else {
+            for (size_t i = 0; i < num_threads_; ++i) {
+                threads_.emplace_back([this, i]() {workerLoop(i); });
+            }
         }
     }
 
     // Destructor
     ~ThreadPool() {
-        stop_.store(true, std::memory_order_release);
+        // blocking tasks still queued run first, they may release work for the workers;
+        // the lane stays alive until the workers are joined, they may still submit to it
+        if (blocking_) {
+            blocking_->shutdown();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stop_.store(true, std::memory_order_release);
+        }
         condition_.notify_all();
         // wait for all threads to finish
         for (auto& thread : threads_) {
@@ -67,15 +777,222 @@ public:
                 thread.join();
             }
         }
+        blocking_.reset();
+    }
+
+    // Getters
+    size_t getNumThreads() const {
+        return num_threads_;
+    }
+    PoolMode getMode() const {
+        return mode_;
+    }
+    // number of nodes with their own queues (1 unless workers are pinned)
+    size_t getNumNodes() const {
+        return node_queues_.size();
     }
-    
-    // add a new task to the pool
+    // cpu the worker is pinned to, -1 if it is not pinned
+    int getWorkerCpu(size_t index) const {
+        return worker_cpu_[index];
+    }
+    size_t getWorkerNode(size_t index) const {
+        return worker_node_[index];
+    }
+    const Topology& getTopology() const {
+        return topology_;
+    }
+    // Runs task now, from the work of a forwarding task (Task::setForwarding) on a worker:
+    // traced and timed as if the worker had picked task itself
+    void runForwarded(Task* task) {
+        if (current_pool_ == this) {
+            runTask(current_index_, task);
+        } else {
+            task->execute();
+        }
+    }
+
+    // lane for blocking tasks (null if disabled)
+    BlockingLane* getBlockingLane() {
+        return blocking_.get();
+    }
+
+    // Setter (statistics, see ThreadPoolOptions::collect_stats; no effect if compiled out)
+    void setStatsEnabled(bool enabled) {
+        collect_stats_.store(enabled, std::memory_order_relaxed);
+    }
+
+    // Snapshot of the statistics collected so far, aggregated over the workers now.
+    // Reading never blocks the workers; counters of a running worker may lag a little.
+    SchedulerStats getStats() const {
+        SchedulerStats stats;
+        stats.workers.resize(worker_stats_.size());
+        for (size_t i = 0; i < worker_stats_.size(); ++i) {
+            stats.workers[i].add(*worker_stats_[i]);
+            stats.total.add(stats.workers[i]);
+        }
+        for (const auto& node : node_queues_) {
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                stats.queued_tasks += node->queued(p);
+            }
+        }
+        for (const auto& queues : local_queues_) {
+            for (const auto& deque : queues->deques) {
+                stats.queued_tasks += static_cast<size_t>(std::max<int64_t>(0, deque.size()));
+            }
+        }
+        stats.sleeping_workers = num_sleeping_.load(std::memory_order_relaxed);
+        stats.spinning_workers = num_spinning_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Setter (tracing; only has an effect if ThreadPoolOptions::trace_events was set)
+    void setTracing(bool enabled) {
+        tracing_.store(enabled && trace_ != nullptr, std::memory_order_relaxed);
+    }
+
+    // Trace buffers (null if the pool was built without them). Export or clear them only
+    // while no task runs, e.g. after waiting for all tasks: workers do not lock their ring.
+    TraceRecorder* getTrace() {
+        return trace_.get();
+    }
+
+    // writes the trace as Chrome Trace JSON (chrome://tracing, ui.perfetto.dev); false on I/O error
+    bool writeChromeTrace(const std::string& path) const {
+        if (!trace_) {
+            return false;
+        }
+        std::ofstream file(path);
+        trace_->writeChromeTrace(file);
+        return static_cast<bool>(file);
+    }
+
+    // Setter: after this many picks a waiting lower class is served before higher ones (0 = no aging)
+    void setAgingLimit(size_t picks) {
+        aging_limit_.store(picks, std::memory_order_relaxed);
+    }
+
+    // index of the calling worker thread, -1 if the caller is not a worker of this pool
+    int currentWorker() const {
+        return current_pool_ == this ? static_cast<int>(current_index_) : -1;
+    }
+
+    // tasks queued where the caller would take its next one from: its own deques on a
+    // work-stealing worker, otherwise the injection queues (approximate)
+    size_t localBacklog() const {
+        size_t backlog = 0;
+        if (mode_ == PoolMode::WORK_STEALING && current_pool_ == this) {
+            for (const auto& deque : local_queues_[current_index_]->deques) {
+                backlog += static_cast<size_t>(deque.size());
+            }
+            return backlog;
+        }
+        for (const auto& node : node_queues_) {
+            for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+                backlog += node->queued(p);
+            }
+        }
+        return backlog;
+    }
+
+    // add a new task to the pool (queued by its priority class and node; blocking tasks go to the lane)
     void submit(Task* newTask) {
+        if (newTask->isBlocking() && blocking_) {
+            blocking_->submit(newTask);
+            return;
+        }
+        size_t priority = priorityIndex(newTask);
+        if (statsEnabled()) {
+            newTask->setReadyTime(sampleSubmission() ? statsClockNs() : 0);
+        }
+        traceReady(newTask);
+
+        if (mode_ == PoolMode::WORK_STEALING) {
+            size_t node = targetNode(newTask, submitterNode());
+            // spawned from a running task on the right node -> own deque, no lock
+            if (current_pool_ == this && worker_node_[current_index_] == node) {
+                local_queues_[current_index_]->deques[priority].push(newTask);
+            } else {
+                pushInjected(node, priority, newTask);
+            }
+            wake(1);
+            return;
+        }
+
+        size_t queued;
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            task_queue_.push(newTask);
+            NodeQueues& node = *node_queues_[0];
+            std::unique_lock<std::mutex> lock = lockQueue(queue_mutex_);
+            node.queues[priority].push(newTask);
+            node.injected[priority].fetch_add(1, std::memory_order_relaxed);
+            queued = sharedQueued();
         } // lock released automatically here
-        condition_.notify_one();
+        wakeShared(queued, 1);
+    }
+
+    // add count tasks at once with a wakeup sized to the batch
+    void submitBatch(Task* const* tasks, size_t count) {
+        if (blocking_) {
+            // rare: blocking tasks are taken out of the batch
+            for (size_t i = 0; i < count; ++i) {
+                if (tasks[i]->isBlocking()) {
+                    std::vector<Task*> compute;
+                    for (size_t j = 0; j < count; ++j) {
+                        if (tasks[j]->isBlocking()) {
+                            blocking_->submit(tasks[j]);
+                        } else {
+                            compute.push_back(tasks[j]);
+                        }
+                    }
+                    submitBatch(compute.data(), compute.size());
+                    return;
+                }
+            }
+        }
+        if (count == 0) {
+            return;
+        }
+        if (statsEnabled()) {
+            uint64_t now = statsClockNs();
+            for (size_t i = 0; i < count; ++i) {
+                tasks[i]->setReadyTime(sampleSubmission() ? now : 0);
+            }
+        }
+        if (tracingEnabled() && current_pool_ == this) {
+            for (size_t i = 0; i < count; ++i) {
+                traceReady(tasks[i]);
+            }
+        }
+
+        if (mode_ == PoolMode::WORK_STEALING) {
+            size_t submitter = submitterNode();
+            if (current_pool_ == this) {
+                for (size_t i = 0; i < count; ++i) {
+                    size_t node = targetNode(tasks[i], submitter);
+                    if (node == submitter) {
+                        local_queues_[current_index_]->deques[priorityIndex(tasks[i])].push(tasks[i]);
+                    } else {
+                        pushInjected(node, priorityIndex(tasks[i]), tasks[i]);
+                    }
+                }
+            } else {
+                pushInjectedBatch(tasks, count, submitter);
+            }
+            wake(count);
+            return;
+        }
+
+        size_t queued;
+        {
+            NodeQueues& node = *node_queues_[0];
+            std::unique_lock<std::mutex> lock = lockQueue(queue_mutex_);
+            for (size_t i = 0; i < count; ++i) {
+                size_t priority = priorityIndex(tasks[i]);
+                node.queues[priority].push(tasks[i]);
+                node.injected[priority].fetch_add(1, std::memory_order_relaxed);
+            }
+            queued = sharedQueued();
+        }
+        wakeShared(queued, count);
     }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,148 @@
+// src/topology.h
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// parses a kernel cpu/node list such as "0-3,8-11" (empty on malformed input)
+inline std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> result;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                result.push_back(cpu);
+            }
+        } catch (...) {
+            return {};
+        }
+    }
+    return result;
+}
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus; // only cpus this process may run on
+};
+
+// NUMA nodes and their cpus as reported by /sys/devices/system/node.
+// Falls back to one node holding every cpu when the information is missing.
+class Topology {
+private:
+    std::vector<NumaNode> nodes_;
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path);
+        std::string content;
+        std::getline(file, content);
+        return content;
+    }
+
+    static bool allowed(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0 || cpu < 0 || cpu >= CPU_SETSIZE) {
+            return true;
+        }
+        return CPU_ISSET(cpu, &set);
+#else
+        (void)cpu;
+        return true;
+#endif
+    }
+
+public:
+    // Constructor (reads the machine's topology)
+    Topology() {
+        for (int node : parseCpuList(readFile("/sys/devices/system/node/online"))) {
+            NumaNode entry{node, {}};
+            std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+            for (int cpu : parseCpuList(readFile(path))) {
+                if (allowed(cpu)) {
+                    entry.cpus.push_back(cpu);
+                }
+            }
+            // memory-only nodes have no workers
+            if (!entry.cpus.empty()) {
+                nodes_.push_back(std::move(entry));
+            }
+        }
+        if (nodes_.empty()) {
+            NumaNode entry{0, {}};
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; ++cpu) {
+                entry.cpus.push_back(static_cast<int>(cpu));
+            }
+            nodes_.push_back(std::move(entry));
+        }
+    }
+
+    // Getters
+    const std::vector<NumaNode>& nodes() const {
+        return nodes_;
+    }
+    size_t numNodes() const {
+        return nodes_.size();
+    }
+
+    // index into nodes() of the node that owns cpu, 0 if unknown
+    size_t nodeOfCpu(int cpu) const {
+        for (size_t n = 0; n < nodes_.size(); ++n) {
+            for (int c : nodes_[n].cpus) {
+                if (c == cpu) {
+                    return n;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // cpu for worker i: workers are dealt round-robin over the nodes so that
+    // every node's memory controller gets used before cores are shared
+    int cpuForWorker(size_t worker) const {
+        const NumaNode& node = nodes_[worker % nodes_.size()];
+        return node.cpus[(worker / nodes_.size()) % node.cpus.size()];
+    }
+};
+
+// cpu the calling thread is running on, -1 if unknown
+inline int currentCpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// pins the calling thread to cpu; false if that is not supported or not allowed
+inline bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,202 @@
+// src/trace_recorder.h
+#pragma once
+
+#include "cache_line.h"
+#include "scheduler_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Tracing can be compiled out (-DTASK_SCHEDULER_TRACE=0); when compiled in, a pool
+// only records if it was given ring buffers (ThreadPoolOptions::trace_events).
+#ifndef TASK_SCHEDULER_TRACE
+#define TASK_SCHEDULER_TRACE 1
+#endif
+
+enum class TraceEventType : uint8_t {
+    TASK_START,
+    TASK_END,
+    READY, // a running task released the last dependency of task_id (or spawned it)
+    STEAL, // task_id was taken from another worker's deque
+    PARK,
+    UNPARK
+};
+
+// fixed-size trace record
+struct TraceEvent {
+    uint64_t time_ns; // statsClockNs()
+    uint64_t task_id;
+    TraceEventType type;
+};
+
+// Ring buffer of one worker: only the owning worker records, without locks or atomic
+// read-modify-writes. When it is full the oldest events are overwritten.
+class TraceBuffer {
+private:
+    std::unique_ptr<TraceEvent[]> events_;
+    size_t mask_;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0}; // events recorded so far
+
+public:
+    // disable copying
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    // Constructor (capacity is rounded up to a power of two)
+    explicit TraceBuffer(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        events_ = std::make_unique<TraceEvent[]>(size);
+        mask_ = size - 1;
+    }
+
+    // Getters
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+    size_t size() const {
+        return static_cast<size_t>(std::min<uint64_t>(head_.load(std::memory_order_acquire), capacity()));
+    }
+    // events lost because the ring wrapped around
+    uint64_t dropped() const {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        return head > capacity() ? head - capacity() : 0;
+    }
+
+    // owning worker only
+    void record(TraceEventType type, uint64_t task_id) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[head & mask_] = TraceEvent{statsClockNs(), task_id, type};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // f(event) for the retained events, oldest first (while the owner does not record)
+    template <typename F>
+    void forEach(F&& f) const {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (uint64_t i = head - size(); i < head; ++i) {
+            f(events_[i & mask_]);
+        }
+    }
+
+    void clear() {
+        head_.store(0, std::memory_order_release);
+    }
+};
+
+// One TraceBuffer per worker, exported as Chrome Trace Event JSON (chrome://tracing,
+// ui.perfetto.dev): tasks and parks become slices on their worker's track, steals are
+// instants, and a READY event is drawn as a flow arrow to the start of that task.
+class TraceRecorder {
+private:
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+
+public:
+    // Constructor
+    TraceRecorder(size_t num_workers, size_t events_per_worker) {
+        for (size_t i = 0; i < num_workers; ++i) {
+            buffers_.push_back(std::make_unique<TraceBuffer>(events_per_worker));
+        }
+    }
+
+    // Getters
+    size_t numWorkers() const {
+        return buffers_.size();
+    }
+    TraceBuffer& buffer(size_t worker) {
+        return *buffers_[worker];
+    }
+    size_t numEvents() const {
+        size_t count = 0;
+        for (const auto& buffer : buffers_) {
+            count += buffer->size();
+        }
+        return count;
+    }
+    uint64_t dropped() const {
+        uint64_t count = 0;
+        for (const auto& buffer : buffers_) {
+            count += buffer->dropped();
+        }
+        return count;
+    }
+
+    void clear() {
+        for (auto& buffer : buffers_) {
+            buffer->clear();
+        }
+    }
+
+    // writes the events as Chrome Trace JSON (call while the workers do not record)
+    void writeChromeTrace(std::ostream& out) const {
+        uint64_t origin = UINT64_MAX;
+        for (const auto& buffer : buffers_) {
+            buffer->forEach([&origin](const TraceEvent& event) {
+                origin = std::min(origin, event.time_ns);
+            });
+        }
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        // opens an event record (timestamps are in microseconds since the first event)
+        auto begin = [&](const char* phase, size_t worker, uint64_t time_ns) -> std::ostream& {
+            uint64_t ns = time_ns - origin;
+            out << (first ? "" : ",\n") << "{\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << worker
+                << ",\"ts\":" << ns / 1000 << '.' << ns % 1000 / 100 << ns % 100 / 10 << ns % 10;
+            first = false;
+            return out;
+        };
+
+        for (size_t worker = 0; worker < buffers_.size(); ++worker) {
+            out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << worker
+                << ",\"name\":\"thread_name\",\"args\":{\"name\":\"worker " << worker << "\"}}";
+            first = false;
+
+            // a wrapped ring may start in the middle of a slice: skip up to its first begin
+            bool open_task = false;
+            bool parked = false;
+            buffers_[worker]->forEach([&](const TraceEvent& event) {
+                switch (event.type) {
+                case TraceEventType::TASK_START:
+                    begin("B", worker, event.time_ns) << ",\"cat\":\"task\",\"name\":\"task "
+                        << event.task_id << "\",\"args\":{\"id\":" << event.task_id << "}}";
+                    begin("f", worker, event.time_ns) << ",\"cat\":\"ready\",\"name\":\"ready\",\"bp\":\"e\",\"id\":"
+                        << event.task_id << "}";
+                    open_task = true;
+                    break;
+                case TraceEventType::TASK_END:
+                    if (open_task) {
+                        begin("E", worker, event.time_ns) << "}";
+                        open_task = false;
+                    }
+                    break;
+                case TraceEventType::READY:
+                    begin("s", worker, event.time_ns) << ",\"cat\":\"ready\",\"name\":\"ready\",\"id\":"
+                        << event.task_id << "}";
+                    break;
+                case TraceEventType::STEAL:
+                    begin("i", worker, event.time_ns) << ",\"s\":\"t\",\"cat\":\"steal\",\"name\":\"steal\",\"args\":{\"id\":"
+                        << event.task_id << "}}";
+                    break;
+                case TraceEventType::PARK:
+                    begin("B", worker, event.time_ns) << ",\"cat\":\"idle\",\"name\":\"park\"}";
+                    parked = true;
+                    break;
+                case TraceEventType::UNPARK:
+                    if (parked) {
+                        begin("E", worker, event.time_ns) << "}";
+                        parked = false;
+                    }
+                    break;
+                }
+            });
+        }
+        out << "\n]}\n";
+    }
+};
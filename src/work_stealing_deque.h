@@ -0,0 +1,137 @@
+// src/work_stealing_deque.h
+#pragma once
+
+#include "cache_line.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Lock-free Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models", PPoPP'13).
+// The owning worker pushes and pops at the bottom (LIFO), any other thread
+// steals from the top (FIFO). Only pointers are stored.
+template <typename T>
+class WorkStealingDeque {
+private:
+    struct Buffer {
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+
+        explicit Buffer(int64_t cap):
+            capacity(cap),
+            mask(cap - 1),
+            slots(new std::atomic<T*>[cap])
+        {}
+
+        T* load(int64_t index) const {
+            return slots[index & mask].load(std::memory_order_relaxed);
+        }
+        void store(int64_t index, T* item) {
+            slots[index & mask].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    // top_ is written by thieves, bottom_ only by the owner -> separate cache lines
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top_;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom_;
+    alignas(CACHE_LINE_SIZE) std::atomic<Buffer*> buffer_;
+
+    // every buffer ever allocated; old ones stay alive because a thief may still read them
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+
+    // owner only: double the capacity and copy the live range
+    Buffer* grow(Buffer* old, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<Buffer>(old->capacity * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->store(i, old->load(i));
+        }
+        Buffer* raw = bigger.get();
+        buffers_.push_back(std::move(bigger));
+        buffer_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+public:
+    // disable copying
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Constructor (capacity must be a power of two)
+    explicit WorkStealingDeque(int64_t capacity = 256):
+        top_(0),
+        bottom_(0)
+    {
+        buffers_.push_back(std::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only: push to the bottom
+    void push(T* item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+        if (bottom - top > buffer->capacity - 1) {
+            buffer = grow(buffer, top, bottom);
+        }
+        buffer->store(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // owner only: pop from the bottom, nullptr if empty
+    T* pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+        if (top <= bottom) {
+            item = buffer->load(bottom);
+            if (top == bottom) {
+                // last element: race against thieves
+                if (!top_.compare_exchange_strong(top, top + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread: steal from the top, nullptr if empty or lost the race
+    T* steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top < bottom) {
+            Buffer* buffer = buffer_.load(std::memory_order_acquire);
+            T* item = buffer->load(top);
+            if (!top_.compare_exchange_strong(top, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+        return nullptr;
+    }
+
+    // approximate number of elements (exact for the owner)
+    int64_t size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? bottom - top : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+};
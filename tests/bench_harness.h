@@ -0,0 +1,329 @@
+// tests/bench_harness.h
+#pragma once
+
+#include "thread_pool.h"
+#include "topology.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Small benchmark harness in the spirit of Google Benchmark (no dependency):
+// every case runs warmups + repetitions times, each run is timed on its own and the
+// suite reports median and MAD (median absolute deviation) of the runs, prints a table
+// and writes JSON that later runs can be compared against (--baseline).
+
+// one run of a case: the body times the part that counts with measure()
+class BenchState {
+private:
+    ThreadPoolOptions options_;
+    double elapsed_ns_ = 0.0;
+    double cpu_ns_ = 0.0;
+    uint64_t items_ = 0;
+
+    static double processCpuNs() {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+    }
+
+public:
+    explicit BenchState(const ThreadPoolOptions& options):
+        options_(options)
+    {}
+
+    // pool options for this run (workers pinned when the suite runs with --pin)
+    ThreadPoolOptions poolOptions(PoolMode mode = PoolMode::WORK_STEALING) const {
+        ThreadPoolOptions options = options_;
+        options.mode = mode;
+        return options;
+    }
+
+    // times f; setup and teardown around it are not counted (may be called more than once)
+    template <typename F>
+    void measure(F&& f) {
+        double cpu_start = processCpuNs();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        cpu_ns_ += processCpuNs() - cpu_start;
+        elapsed_ns_ += std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    // Getters / Setter (items processed per run, for the throughput column)
+    double elapsedNs() const {
+        return elapsed_ns_;
+    }
+    double cpuNs() const {
+        return cpu_ns_;
+    }
+    uint64_t items() const {
+        return items_;
+    }
+    void setItems(uint64_t items) {
+        items_ = items;
+    }
+};
+
+using BenchParams = std::vector<std::pair<std::string, std::string>>;
+
+struct BenchCase {
+    std::string name; // full name: base/param:value/...
+    BenchParams params;
+    std::function<void(BenchState&)> body;
+};
+
+struct BenchConfig {
+    int warmups = 1;
+    int repetitions = 5;
+    bool pin = false;
+    double threshold = 0.05; // relative slowdown of the median that counts as a regression
+    std::string filter;      // only cases whose name contains it
+    std::string json_path;
+    std::string baseline_path;
+    std::vector<size_t> threads; // empty = powers of two up to the cpu count
+};
+
+// median of values (sorted copy)
+inline double benchMedian(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+class BenchSuite {
+private:
+    struct Result {
+        const BenchCase* bench;
+        std::vector<double> samples_ns;
+        double median_ns;
+        double mad_ns;
+        double min_ns;
+        double mean_ns;
+        double cpu_median_ns;
+        uint64_t items;
+    };
+
+    BenchConfig config_;
+    std::vector<BenchCase> cases_;
+
+    static std::string jsonEscape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // "name" -> median_ns of a JSON file written by this suite (one benchmark per line)
+    static std::map<std::string, double> readBaseline(const std::string& path) {
+        std::map<std::string, double> medians;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t name = line.find("\"name\":\"");
+            size_t median = line.find("\"median_ns\":");
+            if (name == std::string::npos || median == std::string::npos) {
+                continue;
+            }
+            name += 8;
+            medians[line.substr(name, line.find('"', name) - name)] = std::stod(line.substr(median + 12));
+        }
+        return medians;
+    }
+
+    Result runCase(const BenchCase& bench, const ThreadPoolOptions& options) const {
+        Result result{&bench, {}, 0, 0, 0, 0, 0, 0};
+        std::vector<double> cpu_samples;
+        for (int i = 0; i < config_.warmups + config_.repetitions; ++i) {
+            BenchState state(options);
+            bench.body(state);
+            if (i < config_.warmups) {
+                continue;
+            }
+            result.samples_ns.push_back(state.elapsedNs());
+            cpu_samples.push_back(state.cpuNs());
+            result.items = state.items();
+        }
+        result.median_ns = benchMedian(result.samples_ns);
+        std::vector<double> deviations;
+        for (double sample : result.samples_ns) {
+            deviations.push_back(std::fabs(sample - result.median_ns));
+        }
+        result.mad_ns = benchMedian(deviations);
+        result.min_ns = *std::min_element(result.samples_ns.begin(), result.samples_ns.end());
+        double sum = 0.0;
+        for (double sample : result.samples_ns) {
+            sum += sample;
+        }
+        result.mean_ns = sum / result.samples_ns.size();
+        result.cpu_median_ns = benchMedian(cpu_samples);
+        return result;
+    }
+
+    void writeJson(const std::vector<Result>& results) const {
+        std::ofstream out(config_.json_path);
+        out.precision(12);
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        out << "{\n\"context\":{\"date\":\"" << date << "\",\"num_cpus\":" << std::thread::hardware_concurrency()
+            << ",\"warmups\":" << config_.warmups << ",\"repetitions\":" << config_.repetitions
+            << ",\"pinned\":" << (config_.pin ? "true" : "false")
+#ifdef NDEBUG
+            << ",\"assertions\":false"
+#else
+            << ",\"assertions\":true"
+#endif
+            << "},\n\"benchmarks\":[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            out << "{\"name\":\"" << jsonEscape(result.bench->name) << "\",\"params\":{";
+            for (size_t p = 0; p < result.bench->params.size(); ++p) {
+                out << (p ? "," : "") << "\"" << jsonEscape(result.bench->params[p].first) << "\":\""
+                    << jsonEscape(result.bench->params[p].second) << "\"";
+            }
+            out << "},\"median_ns\":" << result.median_ns << ",\"mad_ns\":" << result.mad_ns
+                << ",\"min_ns\":" << result.min_ns << ",\"mean_ns\":" << result.mean_ns
+                << ",\"cpu_median_ns\":" << result.cpu_median_ns << ",\"items\":" << result.items
+                << ",\"items_per_second\":" << (result.median_ns > 0 ? result.items / result.median_ns * 1e9 : 0.0)
+                << ",\"samples_ns\":[";
+            for (size_t s = 0; s < result.samples_ns.size(); ++s) {
+                out << (s ? "," : "") << result.samples_ns[s];
+            }
+            out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]}\n";
+    }
+
+public:
+    // --warmups=N --repetitions=N --filter=TEXT --threads=1,2,4 --pin
+    // --json=PATH --baseline=PATH --threshold=PERCENT; false on an unknown argument
+    bool parseArgs(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t equals = arg.find('=');
+            std::string key = arg.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+            if (key == "--warmups") {
+                config_.warmups = std::stoi(value);
+            } else if (key == "--repetitions") {
+                config_.repetitions = std::max(1, std::stoi(value));
+            } else if (key == "--filter") {
+                config_.filter = value;
+            } else if (key == "--pin") {
+                config_.pin = true;
+            } else if (key == "--json") {
+                config_.json_path = value;
+            } else if (key == "--baseline") {
+                config_.baseline_path = value;
+            } else if (key == "--threshold") {
+                config_.threshold = std::stod(value) / 100.0;
+            } else if (key == "--threads") {
+                std::stringstream list(value);
+                std::string count;
+                while (std::getline(list, count, ',')) {
+                    config_.threads.push_back(std::stoul(count));
+                }
+            } else {
+                std::fprintf(stderr, "usage: %s [--warmups=N] [--repetitions=N] [--filter=TEXT] [--threads=1,2,4]"
+                             " [--pin] [--json=PATH] [--baseline=PATH] [--threshold=PERCENT]\n", argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const BenchConfig& config() const {
+        return config_;
+    }
+
+    // thread counts to sweep over
+    std::vector<size_t> threadCounts() const {
+        if (!config_.threads.empty()) {
+            return config_.threads;
+        }
+        std::vector<size_t> counts;
+        size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t count = 1; count < cpus; count *= 2) {
+            counts.push_back(count);
+        }
+        counts.push_back(cpus);
+        return counts;
+    }
+
+    // registers base/key:value/... (params in the given order)
+    void add(const std::string& base, BenchParams params, std::function<void(BenchState&)> body) {
+        std::string name = base;
+        for (const auto& param : params) {
+            name += "/" + param.first + ":" + param.second;
+        }
+        cases_.push_back(BenchCase{name, std::move(params), std::move(body)});
+    }
+
+    // runs the selected cases; returns the exit code (1 if a case regressed against the baseline)
+    int run() {
+        ThreadPoolOptions options;
+        if (config_.pin) {
+            // workers are dealt over the nodes, the submitting thread takes the last cpu of node 0
+            Topology topology;
+            options.pin_workers = true;
+            pinCurrentThread(topology.nodes()[0].cpus.back());
+        }
+        std::map<std::string, double> baseline;
+        if (!config_.baseline_path.empty()) {
+            baseline = readBaseline(config_.baseline_path);
+        }
+
+        std::printf("%-56s %12s %9s %14s %9s\n", "Benchmark", "Median (us)", "MAD (%)", "Items/s", "Baseline");
+        std::printf("%s\n", std::string(104, '-').c_str());
+        std::vector<Result> results;
+        int regressions = 0;
+        for (const BenchCase& bench : cases_) {
+            if (!config_.filter.empty() && bench.name.find(config_.filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(runCase(bench, options));
+            const Result& result = results.back();
+
+            std::string versus = "-";
+            auto old = baseline.find(bench.name);
+            if (old != baseline.end() && old->second > 0) {
+                double change = (result.median_ns - old->second) / old->second;
+                char text[32];
+                std::snprintf(text, sizeof(text), "%+.1f%%%s", change * 100, change > config_.threshold ? " !" : "");
+                versus = text;
+                regressions += change > config_.threshold;
+            }
+            std::printf("%-56s %12.1f %9.1f %14.0f %9s\n", bench.name.c_str(), result.median_ns / 1e3,
+                        result.median_ns > 0 ? result.mad_ns / result.median_ns * 100 : 0.0,
+                        result.median_ns > 0 ? result.items / result.median_ns * 1e9 : 0.0, versus.c_str());
+            std::fflush(stdout);
+        }
+
+        if (!config_.json_path.empty()) {
+            writeJson(results);
+        }
+        if (regressions > 0) {
+            std::printf("\n%d benchmark(s) slower than the baseline by more than %.1f%% (marked !)\n",
+                        regressions, config_.threshold * 100);
+            return 1;
+        }
+        return 0;
+    }
+};
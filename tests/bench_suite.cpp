@@ -0,0 +1,641 @@
+// tests/bench_suite.cpp
+//
+// Repeatable benchmark suite (see bench_harness.h): the scenarios of benchmarks.cpp as
+// parameter sweeps over thread count, task granularity and graph shape.
+//   ./bench_suite --json=new.json --baseline=old.json   (exit code 1 on a regression)
+
+#include "bench_harness.h"
+#include "parallel_algorithms.h"
+#include "task_graph.h"
+#include "task_scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+// busy work of a task (granularity)
+inline void spin(int iterations) {
+    volatile int x = 0;
+    for (int j = 0; j < iterations; ++j) {
+        x += j;
+    }
+}
+
+// edges (dependency, dependent) of a DAG shape over num_tasks nodes
+std::vector<std::pair<size_t, size_t>> graphEdges(const std::string& shape, size_t num_tasks) {
+    std::vector<std::pair<size_t, size_t>> edges;
+    if (shape == "chain") {
+        for (size_t i = 1; i < num_tasks; ++i) {
+            edges.emplace_back(i - 1, i);
+        }
+    } else if (shape == "fan_out") {
+        for (size_t i = 1; i < num_tasks; ++i) {
+            edges.emplace_back(0, i);
+        }
+    } else if (shape == "fan_in") {
+        for (size_t i = 0; i + 1 < num_tasks; ++i) {
+            edges.emplace_back(i, num_tasks - 1);
+        }
+    } else if (shape == "layered") {
+        // layers of 32, every task depends on two tasks of the previous layer
+        const size_t width = 32;
+        for (size_t i = width; i < num_tasks; ++i) {
+            size_t layer_begin = (i / width - 1) * width;
+            edges.emplace_back(layer_begin + i % width, i);
+            edges.emplace_back(layer_begin + (i + 1) % width, i);
+        }
+    } else if (shape == "random") {
+        // every task depends on up to 3 random earlier tasks (fixed seed)
+        std::mt19937 rng(42);
+        for (size_t i = 1; i < num_tasks; ++i) {
+            size_t num_deps = rng() % 4;
+            for (size_t d = 0; d < num_deps; ++d) {
+                edges.emplace_back(rng() % i, i);
+            }
+        }
+    }
+    return edges;
+}
+
+void addThroughputCases(BenchSuite& suite) {
+    const int NUM_TASKS = 10000;
+
+    // independent tasks (benchmark_scaling): submit() one by one, then waitAll()
+    for (size_t threads : suite.threadCounts()) {
+        for (int work : {0, 100, 10000}) {
+            for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+                const char* mode_name = mode == PoolMode::SHARED_QUEUE ? "shared" : "stealing";
+                suite.add("independent", {{"threads", std::to_string(threads)}, {"work", std::to_string(work)},
+                                          {"pool", mode_name}}, [=](BenchState& state) {
+                    TaskScheduler scheduler(threads, state.poolOptions(mode));
+                    state.measure([&]() {
+                        for (int i = 0; i < NUM_TASKS; ++i) {
+                            scheduler.submit([work]() { spin(work); });
+                        }
+                        scheduler.waitAll();
+                    });
+                    state.setItems(NUM_TASKS);
+                });
+            }
+        }
+    }
+
+    // burst from outside the pool: one submit() per task vs one submitBatch()
+    size_t max_threads = suite.threadCounts().back();
+    for (size_t num_tasks : {1000, 100000}) {
+        for (bool batched : {false, true}) {
+            suite.add("burst", {{"threads", std::to_string(max_threads)}, {"tasks", std::to_string(num_tasks)},
+                                {"submit", batched ? "batch" : "single"}}, [=](BenchState& state) {
+                TaskScheduler scheduler(max_threads, state.poolOptions());
+                std::vector<Task*> tasks;
+                for (size_t i = 0; i < num_tasks; ++i) {
+                    tasks.push_back(scheduler.createTask(i, []() {}));
+                }
+                state.measure([&]() {
+                    if (batched) {
+                        scheduler.submitBatch(tasks);
+                    } else {
+                        for (Task* task : tasks) {
+                            scheduler.submit(task);
+                        }
+                    }
+                    scheduler.waitAll();
+                });
+                state.setItems(num_tasks);
+            });
+        }
+    }
+
+    // empty-task throughput at 10M tasks, streamed in waves so the backlog stays bounded
+    suite.add("empty_tasks", {{"threads", std::to_string(max_threads)}, {"tasks", "10M"}}, [=](BenchState& state) {
+        const size_t TOTAL = 10000000;
+        const size_t WAVE = 100000;
+        TaskScheduler scheduler(max_threads, state.poolOptions());
+        state.measure([&]() {
+            for (size_t done = 0; done < TOTAL; done += WAVE) {
+                for (size_t i = 0; i < WAVE; ++i) {
+                    scheduler.submit([]() {});
+                }
+                scheduler.waitAll();
+            }
+        });
+        state.setItems(TOTAL);
+    });
+
+    // task allocation (benchmark_allocation): owned unique_ptr tasks vs pooled vs built in place
+    for (const char* allocation : {"unique_ptr", "pooled", "in_place"}) {
+        suite.add("allocation", {{"threads", std::to_string(max_threads)}, {"tasks", "100000"},
+                                 {"alloc", allocation}}, [=](BenchState& state) {
+            const int TASKS = 100000;
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            std::string kind = allocation;
+            state.measure([&]() {
+                for (int i = 0; i < TASKS; ++i) {
+                    if (kind == "unique_ptr") {
+                        scheduler.submit(std::make_unique<Task>(i, []() {}));
+                    } else if (kind == "pooled") {
+                        scheduler.submit(scheduler.createTask(i, []() {}));
+                    } else {
+                        scheduler.submit([]() {});
+                    }
+                }
+                scheduler.waitAll();
+            });
+            state.setItems(TASKS);
+        });
+    }
+}
+
+void addProducerCases(BenchSuite& suite) {
+    // aggregate submit() throughput of several threads feeding one scheduler at once
+    const int TASKS_PER_PRODUCER = 20000;
+    size_t max_threads = suite.threadCounts().back();
+    for (int producers : {1, 2, 4, 8, 16, 32}) {
+        suite.add("producers", {{"threads", std::to_string(max_threads)}, {"producers", std::to_string(producers)}},
+                  [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            std::atomic<bool> go{false};
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&]() {
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < TASKS_PER_PRODUCER; ++i) {
+                        scheduler.submit([]() {});
+                    }
+                });
+            }
+            state.measure([&]() {
+                go.store(true, std::memory_order_release);
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+                scheduler.waitAll();
+            });
+            state.setItems(producers * TASKS_PER_PRODUCER);
+        });
+    }
+}
+
+void addFailureCases(BenchSuite& suite) {
+    // exception capture: no task throws vs every 100th task throws (collected by waitAll)
+    size_t max_threads = suite.threadCounts().back();
+    for (int every : {0, 100}) {
+        suite.add("failures", {{"threads", std::to_string(max_threads)}, {"tasks", "100000"},
+                               {"throw", every == 0 ? "none" : "1%"}}, [=](BenchState& state) {
+            const int TASKS = 100000;
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            state.measure([&]() {
+                for (int i = 0; i < TASKS; ++i) {
+                    scheduler.submit([every, i]() {
+                        if (every > 0 && i % every == 0) {
+                            throw i;
+                        }
+                    });
+                }
+                try {
+                    scheduler.waitAll();
+                } catch (int) {
+                }
+            });
+            state.setItems(TASKS);
+        });
+    }
+}
+
+void addAdmissionCases(BenchSuite& suite) {
+    // admission control on the submit path: no limit vs a task limit the producer keeps hitting
+    size_t max_threads = suite.threadCounts().back();
+    for (size_t max_tasks : {size_t(0), size_t(1024)}) {
+        suite.add("admission", {{"threads", std::to_string(max_threads)}, {"tasks", "100000"},
+                                {"limit", max_tasks == 0 ? "off" : std::to_string(max_tasks)}}, [=](BenchState& state) {
+            const int TASKS = 100000;
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            AdmissionLimits limits;
+            limits.max_tasks = max_tasks;
+            scheduler.setAdmissionLimits(limits);
+            state.measure([&]() {
+                for (int i = 0; i < TASKS; ++i) {
+                    scheduler.submit([]() {});
+                }
+                scheduler.waitAll();
+            });
+            state.setItems(TASKS);
+        });
+    }
+}
+
+void addValueCases(BenchSuite& suite) {
+    // binary reduction tree over 256 leaves: partial sums in a shared atomic array vs
+    // values passed along the edges (benchmark_dag_values)
+    const int LEAVES = 256;
+    size_t max_threads = suite.threadCounts().back();
+    for (const char* passing : {"atomics", "values"}) {
+        suite.add("values", {{"threads", std::to_string(max_threads)}, {"leaves", std::to_string(LEAVES)},
+                             {"passing", passing}}, [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            std::vector<std::atomic<long>> sums(2 * LEAVES);
+            std::vector<Task*> tasks(2 * LEAVES);
+            std::vector<TaskResult<long>> results(2 * LEAVES);
+            bool values = std::string(passing) == "values";
+            state.measure([&]() {
+                for (int round = 0; round < 20; ++round) {
+                    // node n has children 2n and 2n+1, the leaves are LEAVES..2*LEAVES-1
+                    for (int n = 2 * LEAVES - 1; n >= 1; --n) {
+                        if (values) {
+                            if (n >= LEAVES) {
+                                results[n] = scheduler.submit([n]() { return long(n); });
+                            } else {
+                                results[n] = scheduler.submit([](long a, long b) { return a + b; },
+                                                              std::move(results[2 * n]), std::move(results[2 * n + 1]));
+                            }
+                            continue;
+                        }
+                        if (n >= LEAVES) {
+                            tasks[n] = scheduler.createTask(n, [&sums, n]() {
+                                sums[n].store(n, std::memory_order_relaxed);
+                            });
+                        } else {
+                            tasks[n] = scheduler.createTask(n, [&sums, n]() {
+                                sums[n].store(sums[2 * n].load(std::memory_order_relaxed) +
+                                              sums[2 * n + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                            });
+                            tasks[n]->addDependency(tasks[2 * n]);
+                            tasks[n]->addDependency(tasks[2 * n + 1]);
+                        }
+                    }
+                    if (!values) {
+                        // leaves first: a submitted task may be recycled as soon as it ran
+                        for (int n = 2 * LEAVES - 1; n >= 1; --n) {
+                            scheduler.submit(tasks[n]);
+                        }
+                    }
+                    scheduler.waitAll();
+                    results[1].reset();
+                }
+            });
+            state.setItems(20 * (2 * LEAVES - 1));
+        });
+    }
+}
+
+void addBlockingCases(BenchSuite& suite) {
+    // sleeping loads feeding CPU stages, the loads on the workers vs in the blocking lane
+    // (benchmark_io_lane)
+    const int LOADS = 32;
+    size_t max_threads = suite.threadCounts().back();
+    for (const char* loads : {"workers", "lane"}) {
+        suite.add("io_lane", {{"threads", std::to_string(max_threads)}, {"loads", std::to_string(LOADS)},
+                              {"on", loads}}, [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            bool lane = std::string(loads) == "lane";
+            state.measure([&]() {
+                for (int i = 0; i < LOADS; ++i) {
+                    auto load = [i]() {
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                        return i;
+                    };
+                    TaskResult<int> data = lane ? scheduler.submitBlocking(load) : scheduler.submit(load);
+                    scheduler.submit([](int) { spin(200000); }, std::move(data));
+                }
+                scheduler.waitAll();
+            });
+            state.setItems(LOADS);
+        });
+    }
+}
+
+void addLatencyCases(BenchSuite& suite) {
+    const int ROUND_TRIPS = 1000;
+
+    // submit -> task starts, one task in flight at a time (benchmark_latency / _wakeup),
+    // per idle policy and for HIGH vs LOW priority behind a backlog (benchmark_latency_priority)
+    for (const char* idle : {"park", "spin"}) {
+        suite.add("latency", {{"threads", "4"}, {"idle", idle}}, [=](BenchState& state) {
+            ThreadPoolOptions options = state.poolOptions();
+            options.idle = std::string(idle) == "park" ? IdlePolicy::park() : IdlePolicy::spinThenPark();
+            TaskScheduler scheduler(4, options);
+            state.measure([&]() {
+                for (int i = 0; i < ROUND_TRIPS; ++i) {
+                    std::atomic<bool> started{false};
+                    scheduler.submit([&started]() { started.store(true, std::memory_order_release); });
+                    while (!started.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            scheduler.waitAll();
+            state.setItems(ROUND_TRIPS);
+        });
+    }
+
+    for (TaskPriority priority : {TaskPriority::HIGH, TaskPriority::LOW}) {
+        const char* name = priority == TaskPriority::HIGH ? "high" : "low";
+        suite.add("priority_latency", {{"threads", "2"}, {"priority", name}, {"backlog", "2000"}},
+                  [=](BenchState& state) {
+            TaskScheduler scheduler(2, state.poolOptions());
+            for (int i = 0; i < 2000; ++i) {
+                scheduler.submit([]() { spin(20000); });
+            }
+            std::atomic<bool> started{false};
+            Task* probe = scheduler.createTask(0, [&started]() { started.store(true, std::memory_order_release); });
+            probe->setPriority(priority);
+            state.measure([&]() {
+                scheduler.submit(probe);
+                while (!started.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            });
+            scheduler.waitAll();
+            state.setItems(1);
+        });
+    }
+}
+
+void addGraphCases(BenchSuite& suite) {
+    const size_t NUM_TASKS = 1024;
+
+    // graph shapes, rebuilt per run (pooled tasks, one submitBatch) or replayed as a TaskGraph
+    for (const char* shape : {"chain", "fan_out", "fan_in", "layered", "random"}) {
+        auto edges = graphEdges(shape, NUM_TASKS);
+        for (size_t threads : suite.threadCounts()) {
+            for (int work : {0, 1000}) {
+                BenchParams params = {{"shape", shape}, {"threads", std::to_string(threads)},
+                                      {"work", std::to_string(work)}};
+                BenchParams rebuild = params, replay = params;
+                rebuild.emplace_back("run", "rebuild");
+                replay.emplace_back("run", "replay");
+
+                suite.add("graph", rebuild, [=](BenchState& state) {
+                    TaskScheduler scheduler(threads, state.poolOptions());
+                    state.measure([&]() {
+                        std::vector<Task*> tasks;
+                        tasks.reserve(NUM_TASKS);
+                        for (size_t i = 0; i < NUM_TASKS; ++i) {
+                            tasks.push_back(scheduler.createTask(i, [work]() { spin(work); }));
+                        }
+                        for (const auto& edge : edges) {
+                            tasks[edge.second]->addDependency(tasks[edge.first]);
+                        }
+                        scheduler.submitBatch(tasks);
+                        scheduler.waitAll();
+                    });
+                    state.setItems(NUM_TASKS);
+                });
+
+                suite.add("graph", replay, [=](BenchState& state) {
+                    TaskScheduler scheduler(threads, state.poolOptions());
+                    TaskGraph graph;
+                    for (size_t i = 0; i < NUM_TASKS; ++i) {
+                        graph.addNode([work]() { spin(work); });
+                    }
+                    for (const auto& edge : edges) {
+                        graph.addDependency(edge.second, edge.first);
+                    }
+                    graph.freeze();
+                    state.measure([&]() {
+                        scheduler.run(graph);
+                    });
+                    state.setItems(NUM_TASKS);
+                });
+            }
+        }
+    }
+
+    // startup + run of a 100k-node layered graph of kernel nodes: rebuilt as a TaskGraph vs
+    // mapped from a snapshot file (benchmark_snapshot)
+    for (const char* from : {"rebuild", "mmap"}) {
+        suite.add("snapshot", {{"threads", std::to_string(suite.threadCounts().back())}, {"nodes", "100k"},
+                               {"from", from}}, [=](BenchState& state) {
+            const size_t NODES = 100000;
+            auto edges = graphEdges("layered", NODES);
+            TaskScheduler scheduler(suite.threadCounts().back(), state.poolOptions());
+            KernelRegistry registry;
+            registry.add(0, [](const KernelParams& params) { spin(params.as<int>()); });
+            auto build = [&](TaskGraph& graph) {
+                int work = 10;
+                for (size_t i = 0; i < NODES; ++i) {
+                    graph.addNode(registry, 0, &work, sizeof(work));
+                }
+                for (const auto& edge : edges) {
+                    graph.addDependency(edge.second, edge.first);
+                }
+            };
+            if (std::string(from) == "rebuild") {
+                state.measure([&]() {
+                    TaskGraph graph;
+                    build(graph);
+                    scheduler.run(graph);
+                });
+            } else {
+                char path[] = "/tmp/bench_snapshotXXXXXX";
+                int fd = mkstemp(path);
+                close(fd);
+                {
+                    TaskGraph graph;
+                    build(graph);
+                    GraphSnapshot::write(graph, path);
+                }
+                state.measure([&]() {
+                    GraphSnapshot snapshot;
+                    snapshot.open(path);
+                    scheduler.run(snapshot, registry);
+                });
+                std::remove(path);
+            }
+            state.setItems(NODES);
+        });
+    }
+
+    // a layered subgraph of 100k tasks run with empty work vs pruned by cancelling its root
+    for (bool cancel : {false, true}) {
+        suite.add("cancel", {{"threads", std::to_string(suite.threadCounts().back())}, {"tasks", "100k"},
+                             {"root", cancel ? "cancelled" : "run"}}, [=](BenchState& state) {
+            const size_t WIDTH = 1000, LAYERS = 100;
+            TaskScheduler scheduler(suite.threadCounts().back(), state.poolOptions());
+            std::vector<Task*> tasks = {scheduler.createTask(0, []() {})};
+            for (size_t layer = 0; layer < LAYERS; ++layer) {
+                size_t previous = tasks.size() - (layer == 0 ? 1 : WIDTH);
+                for (size_t i = 0; i < WIDTH; ++i) {
+                    tasks.push_back(scheduler.createTask(tasks.size(), []() {}));
+                    if (layer == 0) {
+                        tasks.back()->addDependency(tasks[0]);
+                    } else {
+                        tasks.back()->addDependency(tasks[previous + i]);
+                        tasks.back()->addDependency(tasks[previous + (i + 1) % WIDTH]);
+                    }
+                }
+            }
+            if (cancel) {
+                tasks[0]->cancel();
+            }
+            state.measure([&]() {
+                scheduler.submitBatch(tasks);
+                scheduler.waitAll();
+            });
+            state.setItems(tasks.size());
+        });
+    }
+
+    // FIFO vs critical-path order on a random layered DAG with skewed costs (benchmark_critical_path)
+    size_t max_threads = suite.threadCounts().back();
+    for (SchedulingPolicy policy : {SchedulingPolicy::FIFO, SchedulingPolicy::CRITICAL_PATH}) {
+        const char* name = policy == SchedulingPolicy::FIFO ? "fifo" : "critical_path";
+        suite.add("critical_path", {{"threads", std::to_string(max_threads)}, {"policy", name}},
+                  [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            scheduler.setSchedulingPolicy(policy);
+            std::mt19937 rng(7);
+            std::vector<std::pair<size_t, size_t>> edges;
+            std::vector<int> costs;
+            size_t prev_begin = 0, prev_end = 0;
+            for (int layer = 0; layer < 30; ++layer) {
+                size_t width = 2 + rng() % 31;
+                size_t begin = costs.size();
+                for (size_t i = 0; i < width; ++i) {
+                    unsigned roll = rng() % 100;
+                    costs.push_back(roll < 80 ? 1 : (roll < 95 ? 8 : 40));
+                    for (size_t d = 0; prev_end > prev_begin && d < 1 + rng() % 3; ++d) {
+                        edges.emplace_back(prev_begin + rng() % (prev_end - prev_begin), costs.size() - 1);
+                    }
+                }
+                prev_begin = begin;
+                prev_end = costs.size();
+            }
+            TaskGraph graph;
+            for (size_t i = 0; i < costs.size(); ++i) {
+                int iterations = costs[i] * 2000;
+                graph.addNode([iterations]() { spin(iterations); });
+                graph.task(i).setCost(costs[i]);
+            }
+            for (const auto& edge : edges) {
+                graph.addDependency(edge.second, edge.first);
+            }
+            graph.freeze();
+            state.measure([&]() {
+                scheduler.run(graph);
+            });
+            state.setItems(costs.size());
+        });
+    }
+}
+
+void addAlgorithmCases(BenchSuite& suite) {
+    const size_t N = 10000000;
+    size_t max_threads = suite.threadCounts().back();
+    auto data = std::make_shared<std::vector<float>>(N);
+    for (size_t i = 0; i < N; ++i) {
+        (*data)[i] = float(i % 1000) * 0.001f;
+    }
+    auto sum_range = [data](size_t lo, size_t hi, double acc) {
+        for (size_t i = lo; i < hi; ++i) {
+            acc += (*data)[i];
+        }
+        return acc;
+    };
+
+    // reductions (benchmark_parallel_algorithms): serial, hand-chunked tasks, parallel_reduce
+    for (const char* variant : {"serial", "chunked", "parallel_reduce"}) {
+        suite.add("reduce", {{"threads", std::to_string(max_threads)}, {"n", "10M"}, {"variant", variant}},
+                  [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            std::string kind = variant;
+            volatile double result = 0.0;
+            state.measure([&]() {
+                if (kind == "serial") {
+                    result = sum_range(0, N, 0.0);
+                } else if (kind == "chunked") {
+                    size_t num_chunks = max_threads * 4;
+                    size_t chunk = (N + num_chunks - 1) / num_chunks;
+                    std::vector<CachePadded<double>> partials(num_chunks, CachePadded<double>(0.0));
+                    for (size_t c = 0; c < num_chunks; ++c) {
+                        scheduler.submit([&, c]() {
+                            partials[c].value = sum_range(c * chunk, std::min(N, (c + 1) * chunk), 0.0);
+                        });
+                    }
+                    scheduler.waitAll();
+                    double sum = 0.0;
+                    for (auto& partial : partials) {
+                        sum += partial.value;
+                    }
+                    result = sum;
+                } else {
+                    result = parallel_reduce(scheduler, 0, N, 0.0, sum_range,
+                                             [](double a, double b) { return a + b; });
+                }
+            });
+            state.setItems(N);
+        });
+    }
+
+    for (const char* variant : {"serial", "parallel_scan"}) {
+        suite.add("scan", {{"threads", std::to_string(max_threads)}, {"n", "10M"}, {"variant", variant}},
+                  [=](BenchState& state) {
+            TaskScheduler scheduler(max_threads, state.poolOptions());
+            std::vector<uint32_t> values(N);
+            for (size_t i = 0; i < N; ++i) {
+                values[i] = uint32_t(i % 1000);
+            }
+            bool serial = std::string(variant) == "serial";
+            state.measure([&]() {
+                if (serial) {
+                    std::partial_sum(values.begin(), values.end(), values.begin());
+                } else {
+                    parallel_scan(scheduler, values.data(), values.data(), N, 0u,
+                                  [](uint32_t a, uint32_t b) { return a + b; });
+                }
+            });
+            state.setItems(N);
+        });
+    }
+}
+
+void addInstrumentationCases(BenchSuite& suite) {
+    // cost of statistics and tracing on short tasks (benchmark_stats_overhead / _trace_overhead)
+    size_t max_threads = suite.threadCounts().back();
+    for (const char* mode : {"off", "stats", "trace"}) {
+        suite.add("instrumentation", {{"threads", std::to_string(max_threads)}, {"work", "100"}, {"mode", mode}},
+                  [=](BenchState& state) {
+            const int TASKS = 10000;
+            ThreadPoolOptions options = state.poolOptions();
+            options.collect_stats = std::string(mode) == "stats";
+            options.trace_events = std::string(mode) == "trace" ? (1 << 16) : 0;
+            TaskScheduler scheduler(max_threads, options);
+            state.measure([&]() {
+                for (int i = 0; i < TASKS; ++i) {
+                    scheduler.submit([]() { spin(100); });
+                }
+                scheduler.waitAll();
+            });
+            state.setItems(TASKS);
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchSuite suite;
+    if (!suite.parseArgs(argc, argv)) {
+        return 2;
+    }
+    addThroughputCases(suite);
+    addProducerCases(suite);
+    addFailureCases(suite);
+    addAdmissionCases(suite);
+    addValueCases(suite);
+    addBlockingCases(suite);
+    addLatencyCases(suite);
+    addGraphCases(suite);
+    addAlgorithmCases(suite);
+    addInstrumentationCases(suite);
+    return suite.run();
+}
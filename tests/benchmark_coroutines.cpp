@@ -0,0 +1,121 @@
+// tests/benchmark_coroutines.cpp
+
+#include "coro_task.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// below this size both variants recurse serially
+const int FIB_CUTOFF = 18;
+const size_t SORT_CUTOFF = 4096;
+
+long serialFib(int n) {
+    return n < 2 ? n : serialFib(n - 1) + serialFib(n - 2);
+}
+
+scheduler_task<long> coroFib(int n) {
+    if (n < FIB_CUTOFF) {
+        co_return serialFib(n);
+    }
+    auto [a, b] = co_await whenAll(coroFib(n - 1), coroFib(n - 2));
+    co_return a + b;
+}
+
+// blocking equivalent: the parent thread waits in get() for its children
+long blockingFib(int n) {
+    if (n < FIB_CUTOFF) {
+        return serialFib(n);
+    }
+    auto a = std::async(std::launch::async, blockingFib, n - 1);
+    long b = blockingFib(n - 2);
+    return a.get() + b;
+}
+
+void mergeHalves(std::vector<int>& data, std::vector<int>& buffer, size_t begin, size_t middle, size_t end) {
+    std::merge(data.begin() + begin, data.begin() + middle, data.begin() + middle, data.begin() + end,
+               buffer.begin() + begin);
+    std::copy(buffer.begin() + begin, buffer.begin() + end, data.begin() + begin);
+}
+
+scheduler_task<void> coroSort(std::vector<int>& data, std::vector<int>& buffer, size_t begin, size_t end) {
+    if (end - begin <= SORT_CUTOFF) {
+        std::sort(data.begin() + begin, data.begin() + end);
+        co_return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    co_await whenAll(coroSort(data, buffer, begin, middle), coroSort(data, buffer, middle, end));
+    mergeHalves(data, buffer, begin, middle, end);
+}
+
+void blockingSort(std::vector<int>& data, std::vector<int>& buffer, size_t begin, size_t end) {
+    if (end - begin <= SORT_CUTOFF) {
+        std::sort(data.begin() + begin, data.begin() + end);
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    auto left = std::async(std::launch::async, blockingSort, std::ref(data), std::ref(buffer), begin, middle);
+    blockingSort(data, buffer, middle, end);
+    left.get();
+    mergeHalves(data, buffer, begin, middle, end);
+}
+
+template <typename F>
+double measureMs(F&& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const int FIB_N = 32;
+    const size_t SORT_SIZE = 10000000;
+
+    ThreadPool pool(num_threads);
+    CoroutineRuntime runtime(pool);
+
+    std::cout << "Benchmark: Coroutine fork-join vs blocking (" << num_threads << " workers)\n";
+    std::cout << "Workload           | Variant    | Time (ms)\n";
+    std::cout << "-------------------|------------|----------\n";
+
+    long expected = serialFib(FIB_N);
+    long result = 0;
+    double coro_ms = measureMs([&]() { result = runtime.run(coroFib(FIB_N)); });
+    if (result != expected) {
+        std::cerr << "coroutine fib mismatch\n";
+        return 1;
+    }
+    std::string name = "fib(" + std::to_string(FIB_N) + ")";
+    printf("%-18s | coroutine  | %9.1f\n", name.c_str(), coro_ms);
+    double blocking_ms = measureMs([&]() { result = blockingFib(FIB_N); });
+    printf("%-18s | blocking   | %9.1f\n", name.c_str(), blocking_ms);
+
+    std::vector<int> input(SORT_SIZE);
+    std::mt19937 rng(7);
+    for (int& value : input) {
+        value = static_cast<int>(rng());
+    }
+    std::vector<int> data = input;
+    std::vector<int> buffer(SORT_SIZE);
+    coro_ms = measureMs([&]() { runtime.run(coroSort(data, buffer, 0, data.size())); });
+    if (!std::is_sorted(data.begin(), data.end())) {
+        std::cerr << "coroutine sort failed\n";
+        return 1;
+    }
+    name = "merge sort (" + std::to_string(SORT_SIZE / 1000000) + "M)";
+    printf("%-18s | coroutine  | %9.1f\n", name.c_str(), coro_ms);
+    data = input;
+    blocking_ms = measureMs([&]() { blockingSort(data, buffer, 0, data.size()); });
+    printf("%-18s | blocking   | %9.1f\n", name.c_str(), blocking_ms);
+
+    std::cout << "\n";
+    return 0;
+}
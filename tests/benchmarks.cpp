@@ -1,5 +1,6 @@
 // tests/benchmark_scaling.cpp
 
+#include "parallel_algorithms.h"
 #include "task_scheduler.h"
 #include <iostream>
 #include <chrono>
@@ -7,139 +8,400 @@
 #include <algorithm>
 #include <numeric>
 #include <atomic>
+#include <ctime>
+#include <cstdio>
+#include <unistd.h>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// counts every heap allocation of the process (allocations per task). The deletes are kept
+// out of line: inlined next to a new, GCC would flag the free() as a mismatch.
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+__attribute__((noinline)) void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+__attribute__((noinline)) void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// over-aligned types (Task is alignas(CACHE_LINE_SIZE)) take these
+void* operator new(size_t size, std::align_val_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    if (void* ptr = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) & ~(align - 1))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+__attribute__((noinline)) void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+__attribute__((noinline)) void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
 
 // Benchmark: Measure performance scaling with number of threads
+// (shared mutex queue vs. work-stealing deques)
 void benchmark_scaling() {
     const int NUM_TASKS = 10000;
-    
-    std::cout << "Benchmark: Thread Scaling (10,000 tasks)\n";
-    std::cout << "Threads | Time (ms) | Tasks/sec | Speedup\n";
-    std::cout << "--------|-----------|-----------|--------\n";
-    
-    double baseline_time = 0;
-    
-    for (size_t num_threads : {1, 2, 4, 8, 16}) {
-        TaskScheduler scheduler(num_threads);
+
+    // runs NUM_TASKS independent tasks with work_iterations of busy work each, returns ms
+    auto run = [&](size_t num_threads, PoolMode mode, int work_iterations) {
+        TaskScheduler scheduler(num_threads, mode);
         std::atomic<int> counter{0};
-        
+
         auto start = std::chrono::high_resolution_clock::now();
-        
+
         // Submit 10 000 independant tasks
         for (int i = 0; i < NUM_TASKS; ++i) {
-            auto task = std::make_unique<Task>(i, [&counter]() {
+            auto task = std::make_unique<Task>(i, [&counter, work_iterations]() {
                 // simulate work
                 counter.fetch_add(1, std::memory_order_relaxed);
-                
-                // simulate high CPU work -> larger delay than scheduling overhead
+
+                // simulate CPU work
                 volatile int x = 0;
-                for (int j = 0; j < 10000; ++j) {
+                for (int j = 0; j < work_iterations; ++j) {
                     x += j;
                 }
             });
             scheduler.submit(std::move(task));
         }
-        
+
         scheduler.waitAll();
-        
+
         auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        
-        double time_ms = duration.count();
-        double tasks_per_sec = (NUM_TASKS / time_ms) * 1000;
-        double speedup = (num_threads == 1) ? 1.0 : (baseline_time / time_ms);
-        
-        if (num_threads == 1) baseline_time = time_ms;
-        
-        printf("%7zu | %9.1f | %9.0f | %6.2fx\n", 
-               num_threads, time_ms, tasks_per_sec, speedup);
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    // heavy tasks: larger delay than scheduling overhead, short tasks: queue cost dominates
+    for (int work_iterations : {10000, 100}) {
+        std::cout << "Benchmark: Thread Scaling (10,000 tasks, " << work_iterations
+                  << " iterations of work per task)\n";
+        std::cout << "Threads | Pool          | Time (ms) | Tasks/sec | Speedup\n";
+        std::cout << "--------|---------------|-----------|-----------|--------\n";
+
+        for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+            const char* name = (mode == PoolMode::SHARED_QUEUE) ? "shared queue" : "work stealing";
+            double baseline_time = 0;
+
+            for (size_t num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+                double time_ms = run(num_threads, mode, work_iterations);
+                double tasks_per_sec = (NUM_TASKS / time_ms) * 1000;
+                double speedup = (num_threads == 1) ? 1.0 : (baseline_time / time_ms);
+
+                if (num_threads == 1) baseline_time = time_ms;
+
+                printf("%7zu | %-13s | %9.1f | %9.0f | %6.2fx\n",
+                       num_threads, name, time_ms, tasks_per_sec, speedup);
+            }
+        }
+        std::cout << "\n";
+    }
+    // burst submission from outside the pool: one submit() per task vs one submitBatch()
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Benchmark: Batch Submission (" << num_threads << " threads, empty tasks)\n";
+    std::cout << "Tasks     | Submission | Submit (ms) | Total (ms) | Tasks/sec\n";
+    std::cout << "----------|------------|-------------|------------|----------\n";
+
+    auto run_burst = [&](size_t num_tasks, bool batched) {
+        TaskScheduler scheduler(num_threads);
+        std::atomic<size_t> counter{0};
+        std::vector<Task*> tasks;
+        tasks.reserve(num_tasks);
+        for (size_t i = 0; i < num_tasks; ++i) {
+            tasks.push_back(scheduler.createTask(i, [&counter]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (batched) {
+            scheduler.submitBatch(tasks);
+        } else {
+            for (Task* task : tasks) {
+                scheduler.submit(task);
+            }
+        }
+        auto submitted = std::chrono::high_resolution_clock::now();
+        scheduler.waitAll();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double submit_ms = std::chrono::duration<double, std::milli>(submitted - start).count();
+        double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        printf("%9zu | %-10s | %11.2f | %10.2f | %9.0f\n", num_tasks, batched ? "batch" : "per task",
+               submit_ms, total_ms, num_tasks / total_ms * 1000);
+    };
+
+    for (size_t num_tasks : {size_t(10000), size_t(1000000)}) {
+        run_burst(num_tasks, false);
+        run_burst(num_tasks, true);
     }
-    
     std::cout << "\n";
 }
 
 
 
-// Benchmark: Measure overhead of submit and end-to-end latency
+// Benchmark: Measure overhead of submit and end-to-end latency per idle policy
 void benchmark_latency() {
     const int NUM_MEASUREMENTS = 1000;
-    TaskScheduler scheduler(4);
-    
-    // Warmup
-    std::cout << "Warming up...\n";
-    for (int i = 0; i < 100; ++i) {
-        auto task = std::make_unique<Task>(i, []() {
-            volatile int x = 0;
-            for (int j = 0; j < 1000; ++j) x += j;
-        });
-        scheduler.submit(std::move(task));
+    const auto SUBMIT_GAP = std::chrono::microseconds(200); // workers run dry between submissions
+
+    // cpu time in ms of the process (all threads) and of the calling thread
+    auto process_cpu_ms = []() {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    };
+    auto thread_cpu_ms = []() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    };
+
+    struct Summary {
+        const char* name;
+        uint64_t median;
+        uint64_t p99;
+        double idle_cpu_percent;
+    };
+    std::vector<Summary> summaries;
+
+    auto run = [&](const char* policy_name, IdlePolicy idle) {
+        ThreadPoolOptions options;
+        options.idle = idle;
+        TaskScheduler scheduler(4, options);
+
+        // Warmup
+        std::cout << "Warming up (" << policy_name << ")...\n";
+        for (int i = 0; i < 100; ++i) {
+            auto task = std::make_unique<Task>(i, []() {
+                volatile int x = 0;
+                for (int j = 0; j < 1000; ++j) x += j;
+            });
+            scheduler.submit(std::move(task));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        // 2 separate vectors for the two metrics
+        std::vector<uint64_t> submit_overhead;
+        std::vector<uint64_t> end_to_end_latency;
+        submit_overhead.reserve(NUM_MEASUREMENTS);
+        end_to_end_latency.reserve(NUM_MEASUREMENTS);
+
+        // cpu the workers burn while idling between the sparse submissions (the submitting
+        // thread's own waiting is taken out), per wall time of the loop
+        double cpu_start = process_cpu_ms() - thread_cpu_ms();
+        auto wall_start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < NUM_MEASUREMENTS; ++i) {
+            std::this_thread::sleep_for(SUBMIT_GAP);
+            std::atomic<bool> task_started{false};
+            auto task_start_time = std::chrono::high_resolution_clock::now();
+
+            auto task = std::make_unique<Task>(i, [&]() {
+                task_start_time = std::chrono::high_resolution_clock::now();
+                task_started.store(true, std::memory_order_release);
+            });
+
+            auto e2e_start = std::chrono::high_resolution_clock::now();
+
+            auto submit_start = std::chrono::high_resolution_clock::now();
+            scheduler.submit(std::move(task));
+            auto submit_end = std::chrono::high_resolution_clock::now();
+
+            while (!task_started.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            // submit overhead:
+            uint64_t submit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                submit_end - submit_start).count();
+
+            // End-to End latency
+            uint64_t e2e_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                task_start_time - e2e_start).count();
+
+            submit_overhead.push_back(submit_ns);
+            end_to_end_latency.push_back(e2e_ns);
+        }
+
+        double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+        double idle_cpu = (process_cpu_ms() - thread_cpu_ms() - cpu_start) / wall_ms * 100.0;
+        scheduler.waitAll();
+
+        // calculate and print stats
+        auto print_stats = [](const std::string& name, std::vector<uint64_t>& data) {
+            std::sort(data.begin(), data.end());
+
+            uint64_t min = data.front();
+            uint64_t max = data.back();
+            uint64_t median = data[data.size() / 2];
+            uint64_t p95 = data[(data.size() * 95) / 100];
+            uint64_t p99 = data[(data.size() * 99) / 100];
+            double avg = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+
+            std::cout << "\n" << name << ":\n";
+            std::cout << "  Min:    " << min << " ns\n";
+            std::cout << "  Avg:    " << avg << " ns\n";
+            std::cout << "  Median: " << median << " ns\n";
+            std::cout << "  P95:    " << p95 << " ns\n";
+            std::cout << "  P99:    " << p99 << " ns\n";
+            std::cout << "  Max:    " << max << " ns\n";
+        };
+
+        std::cout << "\nBenchmark: Latency Analysis (" << NUM_MEASUREMENTS << " measurements, "
+                  << policy_name << ")\n";
+        std::cout << "=================================================================\n";
+
+        print_stats("1) submit() Overhead (pure scheduling cost)", submit_overhead);
+        print_stats("2) End-to-End Latency (submit → task starts)", end_to_end_latency);
+        std::cout << "  Idle CPU: " << idle_cpu << " % of one core (workers, during the submissions)\n\n";
+
+        summaries.push_back({policy_name, end_to_end_latency[end_to_end_latency.size() / 2],
+                             end_to_end_latency[(end_to_end_latency.size() * 99) / 100], idle_cpu});
+    };
+
+    run("park", IdlePolicy::park());
+    run("spin, yield, park", IdlePolicy::spinThenPark());
+
+    std::cout << "Idle Policy       | Median e2e (ns) | P99 e2e (ns) | Idle CPU (%)\n";
+    std::cout << "------------------|-----------------|--------------|-------------\n";
+    for (const Summary& summary : summaries) {
+        printf("%-17s | %15llu | %12llu | %11.1f\n", summary.name,
+               (unsigned long long)summary.median, (unsigned long long)summary.p99, summary.idle_cpu_percent);
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::cout << "\n";
+}
 
-    // 2 separate vectors for the two metrics
-    std::vector<uint64_t> submit_overhead;
-    std::vector<uint64_t> end_to_end_latency;
-    submit_overhead.reserve(NUM_MEASUREMENTS);
-    end_to_end_latency.reserve(NUM_MEASUREMENTS);
-    
-    for (int i = 0; i < NUM_MEASUREMENTS; ++i) {        
-        std::atomic<bool> task_started{false};
-        auto task_start_time = std::chrono::high_resolution_clock::now();
 
-        auto task = std::make_unique<Task>(i, [&]() {
-            task_start_time = std::chrono::high_resolution_clock::now();
-            task_started.store(true, std::memory_order_release);
-        });
-        
-        auto e2e_start = std::chrono::high_resolution_clock::now();
 
-        auto submit_start = std::chrono::high_resolution_clock::now();
-        scheduler.submit(std::move(task));
-        auto submit_end = std::chrono::high_resolution_clock::now();
+// Benchmark: Tail latency per priority class under a saturating LOW flood
+void benchmark_latency_priority() {
+    const int NUM_PROBES = 500;       // per probing class
+    const int FLOOD_BACKLOG = 10000;  // LOW tasks kept queued at all times
+
+    std::cout << "Benchmark: Mixed-Priority Latency (4 threads, LOW flood with "
+              << FLOOD_BACKLOG << " queued tasks)\n";
+    std::cout << "Run          | Class  | Samples | Median (us) | P99 (us)\n";
+    std::cout << "-------------|--------|---------|-------------|---------\n";
+
+    auto now_ns = []() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    auto busy = [](int iterations) {
+        volatile int x = 0;
+        for (int j = 0; j < iterations; ++j) x += j;
+    };
+
+    for (bool use_priorities : {false, true}) {
+        TaskScheduler scheduler(4);
+        std::atomic<bool> stop_flood{false};
+        std::atomic<int> in_flight{0};
+        std::mutex samples_mutex;
+        std::vector<int64_t> samples[NUM_PRIORITIES];
+
+        auto submit = [&](std::unique_ptr<Task> task) {
+            scheduler.submit(std::move(task));
+        };
+
+        auto make_task = [&](uint64_t id, TaskPriority priority) {
+            int64_t submitted = now_ns();
+            auto task = std::make_unique<Task>(id, [&, submitted, priority]() {
+                int64_t latency = now_ns() - submitted;
+                {
+                    std::lock_guard<std::mutex> lock(samples_mutex);
+                    samples[static_cast<size_t>(priority)].push_back(latency);
+                }
+                busy(priority == TaskPriority::LOW ? 20000 : 200);
+                if (priority == TaskPriority::LOW) {
+                    in_flight.fetch_sub(1, std::memory_order_relaxed);
+                }
+            });
+            task->setPriority(use_priorities ? priority : TaskPriority::NORMAL);
+            return task;
+        };
 
-        while (!task_started.load(std::memory_order_acquire)) {
+        // producer keeping the pool saturated with LOW work
+        std::thread flood([&]() {
+            uint64_t id = 1000000;
+            while (!stop_flood.load(std::memory_order_acquire)) {
+                if (in_flight.load(std::memory_order_relaxed) < FLOOD_BACKLOG) {
+                    in_flight.fetch_add(1, std::memory_order_relaxed);
+                    submit(make_task(id++, TaskPriority::LOW));
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        // let the backlog build up
+        while (in_flight.load(std::memory_order_relaxed) < FLOOD_BACKLOG) {
             std::this_thread::yield();
         }
-        
-        // submit overhead:
-        uint64_t submit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            submit_end - submit_start).count();
-        
-        // End-to End latency
-        uint64_t e2e_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            task_start_time - e2e_start).count();
-        
-        submit_overhead.push_back(submit_ns);
-        end_to_end_latency.push_back(e2e_ns);
+
+        for (int i = 0; i < NUM_PROBES; ++i) {
+            submit(make_task(2 * i, TaskPriority::HIGH));
+            submit(make_task(2 * i + 1, TaskPriority::NORMAL));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        // wait for the probes before stopping the flood
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(samples_mutex);
+                if (samples[0].size() == NUM_PROBES && samples[1].size() == NUM_PROBES) break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stop_flood.store(true, std::memory_order_release);
+        flood.join();
+        scheduler.waitAll();
+
+        const char* names[NUM_PRIORITIES] = {"HIGH", "NORMAL", "LOW"};
+        for (size_t p = 0; p < NUM_PRIORITIES; ++p) {
+            auto& data = samples[p];
+            std::sort(data.begin(), data.end());
+            printf("%-12s | %-6s | %7zu | %11.1f | %8.1f\n",
+                   use_priorities ? "priorities" : "FIFO (off)", names[p], data.size(),
+                   data[data.size() / 2] / 1000.0, data[(data.size() * 99) / 100] / 1000.0);
+        }
     }
-    
-    scheduler.waitAll();
-    
-    // calculate and print stats
-    auto print_stats = [](const std::string& name, std::vector<uint64_t>& data) {
-        std::sort(data.begin(), data.end());
-        
-        uint64_t min = data.front();
-        uint64_t max = data.back();
-        uint64_t median = data[data.size() / 2];
-        uint64_t p95 = data[(data.size() * 95) / 100];
-        uint64_t p99 = data[(data.size() * 99) / 100];
-        double avg = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
-        
-        std::cout << "\n" << name << ":\n";
-        std::cout << "  Min:    " << min << " ns\n";
-        std::cout << "  Avg:    " << avg << " ns\n";
-        std::cout << "  Median: " << median << " ns\n";
-        std::cout << "  P95:    " << p95 << " ns\n";
-        std::cout << "  P99:    " << p99 << " ns\n";
-        std::cout << "  Max:    " << max << " ns\n";
-    };
-    
-    std::cout << "\nBenchmark: Latency Analysis (" << NUM_MEASUREMENTS << " measurements)\n";
-    std::cout << "=================================================================\n";
-    
-    print_stats("1) submit() Overhead (pure scheduling cost)", submit_overhead);
-    print_stats("2) End-to-End Latency (submit → task starts)", end_to_end_latency);
-    
     std::cout << "\n";
 }
 
@@ -250,8 +512,165 @@ void benchmark_dependencies() {
 
 
 
+// Benchmark: Dependency wakeup cost for wide fan-out / fan-in graphs
+// (per-node cost should stay flat as the graph grows)
+void benchmark_wakeup() {
+    std::cout << "Benchmark: Dependency Wakeup Scaling\n";
+    std::cout << "Shape   |   Nodes | Time (ms) | ns/node\n";
+    std::cout << "--------|---------|-----------|--------\n";
+
+    for (int num_nodes : {1000, 10000, 100000}) {
+        // Fan-out: 1 root -> num_nodes dependents
+        {
+            TaskScheduler scheduler(8);
+            std::atomic<int> counter{0};
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            auto root = std::make_unique<Task>(0, [&counter]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+            Task* root_ptr = root.get();
+
+            std::vector<std::unique_ptr<Task>> dependents;
+            dependents.reserve(num_nodes);
+            for (int i = 1; i <= num_nodes; ++i) {
+                auto task = std::make_unique<Task>(i, [&counter]() {
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                });
+                task->addDependency(root_ptr);
+                dependents.push_back(std::move(task));
+            }
+            for (auto& task : dependents) {
+                scheduler.submit(std::move(task));
+            }
+            scheduler.submit(std::move(root));
+            scheduler.waitAll();
+
+            auto end = std::chrono::high_resolution_clock::now();
+            double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+            printf("fan-out | %7d | %9.2f | %7.1f\n", num_nodes, time_ms, time_ms * 1e6 / num_nodes);
+        }
+
+        // Fan-in: num_nodes roots -> 1 sink
+        {
+            TaskScheduler scheduler(8);
+            std::atomic<int> counter{0};
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            auto sink = std::make_unique<Task>(0, [&counter]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+
+            std::vector<std::unique_ptr<Task>> roots;
+            roots.reserve(num_nodes);
+            for (int i = 1; i <= num_nodes; ++i) {
+                auto task = std::make_unique<Task>(i, [&counter]() {
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                });
+                sink->addDependency(task.get());
+                roots.push_back(std::move(task));
+            }
+            scheduler.submit(std::move(sink));
+            for (auto& task : roots) {
+                scheduler.submit(std::move(task));
+            }
+            scheduler.waitAll();
+
+            auto end = std::chrono::high_resolution_clock::now();
+            double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+            printf("fan-in  | %7d | %9.2f | %7.1f\n", num_nodes, time_ms, time_ms * 1e6 / num_nodes);
+        }
+    }
+
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: CPU time burnt by the waiting thread and wake-up latency after the last task
+void benchmark_wait() {
+    const int NUM_TASKS = 64;
+
+    std::cout << "Benchmark: Waiting (" << NUM_TASKS << " tasks sleeping 5 ms on 8 threads)\n";
+    std::cout << "Wait strategy        | Wall (ms) | Waiter CPU (ms) | Wake-up latency (us)\n";
+    std::cout << "---------------------|-----------|-----------------|---------------------\n";
+
+    auto thread_cpu_ms = []() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    };
+    auto now_ns = []() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+
+    // 0 = waitAll(), 1 = TaskGroup::wait(), 2 = spinning poll (old waitAll behaviour)
+    for (int strategy = 0; strategy < 3; ++strategy) {
+        TaskScheduler scheduler(8);
+        TaskGroup group;
+        std::atomic<int> finished{0};
+        std::atomic<int64_t> last_finish_ns{0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_TASKS; ++i) {
+            auto task = std::make_unique<Task>(i, [&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                if (finished.fetch_add(1, std::memory_order_acq_rel) == NUM_TASKS - 1) {
+                    last_finish_ns.store(now_ns(), std::memory_order_release);
+                }
+            });
+            scheduler.submit(std::move(task), group);
+        }
+
+        double cpu_start = thread_cpu_ms();
+        if (strategy == 0) {
+            scheduler.waitAll();
+        } else if (strategy == 1) {
+            group.wait();
+        } else {
+            while (group.pending() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        int64_t woke_ns = now_ns();
+        double cpu_ms = thread_cpu_ms() - cpu_start;
+        auto end = std::chrono::steady_clock::now();
+
+        const char* name = (strategy == 0) ? "waitAll() (blocking)" :
+                           (strategy == 1) ? "TaskGroup::wait()" : "spin + yield poll";
+        printf("%-20s | %9.1f | %15.3f | %20.1f\n", name,
+               std::chrono::duration<double, std::milli>(end - start).count(), cpu_ms,
+               (woke_ns - last_finish_ns.load(std::memory_order_acquire)) / 1000.0);
+    }
+
+    std::cout << "\n";
+}
+
+
+
+// resident set size of this process in MB (Linux only, 0 elsewhere)
+double current_rss_mb() {
+    long pages = 0;
+    long resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024.0) / 1024.0;
+}
+
+
+
 // Benchmark: Measure object pooling for Task allocation
-void benchmark_allocation() {
+// (large: stream 100M tasks per allocation instead of 10M)
+void benchmark_allocation(bool large = false) {
     const int NUM_ITERATIONS = 100000;
     
     std::cout << "Benchmark: Task Allocation\n\n";
@@ -285,55 +704,1043 @@ void benchmark_allocation() {
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
         
         std::cout << "make_unique: " << duration.count() << " μs\n";
+        std::cout << "  Per task: " << (duration.count() * 1000.0 / NUM_ITERATIONS) << " ns\n";
+    }
+
+    // Test 3: slab pool (external thread -> locked shared free list)
+    {
+        TaskPool task_pool(1);
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            Task* task = task_pool.create(-1, i, [](){});
+            task_pool.destroy(-1, task);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        std::cout << "TaskPool: " << duration.count() << " μs\n";
         std::cout << "  Per task: " << (duration.count() * 1000.0 / NUM_ITERATIONS) << " ns\n\n";
     }
+
+    // Test 4: heap allocations per task through the scheduler (24-byte capture)
+    {
+        const int NUM_TASKS = 100000;
+        std::cout << "Heap allocations per task (24-byte capture, " << NUM_TASKS << " tasks)\n";
+        std::cout << "  (the std::function row approximates the old std::function-based Task: the\n"
+                  << "   std::function is wrapped in the current Task's InlineFunction)\n";
+
+        // 0 = std::function wrapped in the current Task (approximates the old Task),
+        // 1 = inline callable + make_unique, 2 = submit(F&&) built in place in the pool
+        for (int variant = 0; variant < 3; ++variant) {
+            TaskScheduler scheduler(4);
+            std::atomic<long long> sum{0};
+            long long a = 1, b = 2;
+
+            size_t before = g_allocations.load(std::memory_order_relaxed);
+            for (int i = 0; i < NUM_TASKS; ++i) {
+                auto work = [&sum, a, b]() { sum.fetch_add(a + b, std::memory_order_relaxed); };
+                if (variant == 0) {
+                    std::function<void()> wrapped = work;
+                    scheduler.submit(std::make_unique<Task>(i, std::move(wrapped)));
+                } else if (variant == 1) {
+                    scheduler.submit(std::make_unique<Task>(i, work));
+                } else {
+                    scheduler.submit(work);
+                }
+            }
+            scheduler.waitAll();
+            size_t allocations = g_allocations.load(std::memory_order_relaxed) - before;
+
+            const char* name = (variant == 0) ? "std::function (approx. old)" :
+                               (variant == 1) ? "InlineFunction + make_unique" : "submit(F&&) in place";
+            printf("  %-28s: %.3f allocations/task\n", name, double(allocations) / NUM_TASKS);
+        }
+        std::cout << "\n";
+    }
+
+    // Test 5: steady-state RSS while streaming tasks through the scheduler
+    const long long NUM_STREAMED = large ? 100000000 : 10000000;
+    const int WAVE = 100000;
+
+    std::cout << "Steady state (" << NUM_STREAMED / 1000000 << "M tasks in waves of "
+              << WAVE << ", 8 threads)\n";
+    std::cout << "Allocation  | Tasks done | RSS (MB) | Mtasks/sec\n";
+    std::cout << "------------|------------|----------|-----------\n";
+
+    for (bool pooled : {false, true}) {
+        TaskScheduler scheduler(8);
+        std::atomic<long long> counter{0};
+        const char* name = pooled ? "TaskPool" : "make_unique";
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (long long done = 0; done < NUM_STREAMED; done += WAVE) {
+            for (int i = 0; i < WAVE; ++i) {
+                auto work = [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); };
+                if (pooled) {
+                    scheduler.submit(scheduler.createTask(done + i, work));
+                } else {
+                    scheduler.submit(std::make_unique<Task>(done + i, work));
+                }
+            }
+            scheduler.waitAll();
+
+            if ((done + WAVE) % (NUM_STREAMED / 10) == 0) {
+                auto now = std::chrono::high_resolution_clock::now();
+                double seconds = std::chrono::duration<double>(now - start).count();
+                printf("%-11s | %9lldM | %8.1f | %9.2f\n", name, (done + WAVE) / 1000000,
+                       current_rss_mb(), (done + WAVE) / seconds / 1e6);
+            }
+        }
+    }
+    std::cout << "\n";
 }
 
 
 
-// Benchmark: DAG Processing -> Realistic Scenario
-void benchmark_dag() {
-    std::cout << "Benchmark: DAG Processing (Realistic Workload)\n\n";
-    
-    TaskScheduler scheduler(8);
-    
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    // simulate workflow:
-    // Layer 1: 10 Data-Load Tasks
-    // Layer 2: 50 Processing Tasks (wait for layer 1)
-    // Layer 3: 10 Aggregation Tasks (wait for layer 2)
-    // Layer 4: 1 Final Task (wait for layer 3)
-    
-    std::vector<Task*> layer1, layer2, layer3;
-    std::atomic<int> result{0};
-    
-    // Layer 1: Load
-    for (int i = 0; i < 10; ++i) {
-        auto task = std::make_unique<Task>(i, [&result]() {
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-            result.fetch_add(1, std::memory_order_relaxed);
-        });
-        layer1.push_back(task.get());
-        scheduler.submit(std::move(task));
+// hardware cache-miss counter for this process and threads started after construction
+// (reports -1 if perf events are not available, e.g. in containers)
+class CacheMissCounter {
+private:
+    int fd_ = -1;
+
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
     }
-    
-    // Layer 2: Process
-    for (int i = 0; i < 50; ++i) {
-        auto task = std::make_unique<Task>(10 + i, [&result]() {
-            std::this_thread::sleep_for(std::chrono::microseconds(50));
-            result.fetch_add(1, std::memory_order_relaxed);
-        });
-        
-        task->addDependency(layer1[i % 10]);
-        task->addDependency(layer1[(i + 1) % 10]);
-        
-        layer2.push_back(task.get());
-        scheduler.submit(std::move(task));
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
     }
-    
-    // Layer 3: Aggregate
-    for (int i = 0; i < 10; ++i) {
+
+    long long read() const {
+#ifdef __linux__
+        long long count = 0;
+        if (fd_ >= 0 && ::read(fd_, &count, sizeof(count)) == sizeof(count)) {
+            return count;
+        }
+#endif
+        return -1;
+    }
+};
+
+
+
+// Benchmark: Task layout under 64 workers releasing dependencies on pooled tasks.
+// The layouts cannot share a binary: compare `benchmarks --cache-layout` with
+// `benchmarks_packed_task --cache-layout` (built with TASK_SCHEDULER_PACKED_TASK=1).
+void benchmark_cache_layout() {
+    const int NUM_THREADS = 64;
+    const int FAN_IN = 4096;      // predecessors of one task
+    const int FAN_IN_ROUNDS = 50;
+    const int CHAIN_LENGTH = 1000; // one chain per worker, tasks of different chains adjacent in the slabs
+
+    std::cout << "Benchmark: Task Layout (" << NUM_THREADS << " threads, "
+              << (TASK_SCHEDULER_PACKED_TASK ? "packed" : "padded") << ": sizeof(Task) = "
+              << sizeof(Task) << ", alignof(Task) = " << alignof(Task) << ")\n";
+    std::cout << "Workload         | Time (ms) | Mreleases/sec | Cache misses\n";
+    std::cout << "-----------------|-----------|---------------|-------------\n";
+
+    auto report = [](const char* name, double time_ms, double releases, long long misses) {
+        double rate = releases / time_ms / 1000.0;
+        if (misses >= 0) {
+            printf("%-16s | %9.1f | %13.2f | %12lld\n", name, time_ms, rate, misses);
+        } else {
+            printf("%-16s | %9.1f | %13.2f | %12s\n", name, time_ms, rate, "n/a");
+        }
+    };
+
+    // wide fan-in: every worker completes predecessors of the same task (its dependency
+    // counter is the one contended line), the predecessors sit next to each other in the slabs
+    {
+        CacheMissCounter misses;
+        TaskScheduler scheduler(NUM_THREADS);
+        std::atomic<int> sinks{0};
+        std::vector<Task*> tasks(FAN_IN + 1);
+        double time_ms = 0;
+        long long misses_before = misses.read();
+        for (int round = 0; round < FAN_IN_ROUNDS; ++round) {
+            Task* sink = scheduler.createTask(0, [&sinks]() {
+                sinks.fetch_add(1, std::memory_order_relaxed);
+            });
+            for (int i = 0; i < FAN_IN; ++i) {
+                tasks[i] = scheduler.createTask(i + 1, []() {});
+                sink->addDependency(tasks[i]);
+            }
+            tasks[FAN_IN] = sink;
+            auto start = std::chrono::high_resolution_clock::now();
+            scheduler.submitBatch(tasks.data(), tasks.size());
+            scheduler.waitAll();
+            auto end = std::chrono::high_resolution_clock::now();
+            time_ms += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        long long misses_after = misses.read();
+        if (sinks.load() != FAN_IN_ROUNDS) {
+            std::abort();
+        }
+        report("fan-in", time_ms, double(FAN_IN) * FAN_IN_ROUNDS,
+               misses_before >= 0 && misses_after >= 0 ? misses_after - misses_before : -1);
+    }
+
+    // independent chains created interleaved: each completion writes its own task and the
+    // counter of its successor while other workers do the same on the neighbouring tasks
+    {
+        CacheMissCounter misses;
+        TaskScheduler scheduler(NUM_THREADS);
+        std::atomic<int> steps{0};
+        std::vector<Task*> tasks;
+        tasks.reserve(size_t(NUM_THREADS) * CHAIN_LENGTH);
+        for (int i = 0; i < CHAIN_LENGTH; ++i) {
+            for (int chain = 0; chain < NUM_THREADS; ++chain) {
+                Task* task = scheduler.createTask(tasks.size(), [&steps]() {
+                    steps.fetch_add(1, std::memory_order_relaxed);
+                });
+                if (i > 0) {
+                    task->addDependency(tasks[tasks.size() - NUM_THREADS]);
+                }
+                tasks.push_back(task);
+            }
+        }
+        long long misses_before = misses.read();
+        auto start = std::chrono::high_resolution_clock::now();
+        scheduler.submitBatch(tasks.data(), tasks.size());
+        scheduler.waitAll();
+        auto end = std::chrono::high_resolution_clock::now();
+        long long misses_after = misses.read();
+        if (steps.load() != NUM_THREADS * CHAIN_LENGTH) {
+            std::abort();
+        }
+        report("adjacent chains", std::chrono::duration<double, std::milli>(end - start).count(),
+               double(NUM_THREADS) * (CHAIN_LENGTH - 1),
+               misses_before >= 0 && misses_after >= 0 ? misses_after - misses_before : -1);
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: Critical-path (upward rank) dispatch vs FIFO on random layered DAGs
+void benchmark_critical_path() {
+    const size_t NUM_THREADS = 4;
+    const int NUM_LAYERS = 40;
+    const int ITERATIONS_PER_UNIT = 2000; // busy work per cost unit
+
+    std::cout << "Benchmark: Critical Path Scheduling (random layered DAGs, "
+              << NUM_THREADS << " threads)\n";
+    std::cout << "Seed | Tasks | Work (units) | Path (units) | FIFO (ms) | Rank (ms) | Gain\n";
+    std::cout << "-----|-------|--------------|--------------|-----------|-----------|------\n";
+
+    // deep and uneven: widths 2..48 per layer, mostly cheap tasks with a few heavy ones,
+    // every task depends on 1..3 tasks of the previous layer
+    struct Node {
+        int cost;
+        std::vector<size_t> deps;
+    };
+    auto generate = [&](unsigned seed) {
+        std::mt19937 rng(seed);
+        std::vector<Node> nodes;
+        size_t prev_begin = 0, prev_end = 0;
+        for (int layer = 0; layer < NUM_LAYERS; ++layer) {
+            size_t width = 2 + rng() % 47;
+            size_t begin = nodes.size();
+            for (size_t i = 0; i < width; ++i) {
+                Node node;
+                unsigned roll = rng() % 100;
+                node.cost = roll < 80 ? 1 : (roll < 95 ? 8 : 40);
+                if (prev_end > prev_begin) {
+                    size_t num_deps = 1 + rng() % 3;
+                    for (size_t d = 0; d < num_deps; ++d) {
+                        node.deps.push_back(prev_begin + rng() % (prev_end - prev_begin));
+                    }
+                }
+                nodes.push_back(std::move(node));
+            }
+            prev_begin = begin;
+            prev_end = nodes.size();
+        }
+        return nodes;
+    };
+
+    // builds the graph, ranks it and returns the makespan in ms
+    auto run = [&](const std::vector<Node>& nodes, SchedulingPolicy policy, double& path) {
+        TaskScheduler scheduler(NUM_THREADS);
+        scheduler.setSchedulingPolicy(policy);
+
+        std::vector<Task*> tasks;
+        tasks.reserve(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            int iterations = nodes[i].cost * ITERATIONS_PER_UNIT;
+            Task* task = scheduler.createTask(i, [iterations]() {
+                volatile int x = 0;
+                for (int j = 0; j < iterations; ++j) {
+                    x += j;
+                }
+            });
+            task->setCost(nodes[i].cost);
+            for (size_t dep : nodes[i].deps) {
+                task->addDependency(tasks[dep]);
+            }
+            tasks.push_back(task);
+        }
+        computeUpwardRanks(tasks);
+        path = 0.0;
+        for (Task* task : tasks) {
+            path = std::max(path, task->getRank());
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Task* task : tasks) {
+            scheduler.submit(task);
+        }
+        scheduler.waitAll();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    for (unsigned seed : {1u, 2u, 3u}) {
+        std::vector<Node> nodes = generate(seed);
+        long work = 0;
+        for (const Node& node : nodes) {
+            work += node.cost;
+        }
+        double path = 0.0;
+        double fifo_ms = run(nodes, SchedulingPolicy::FIFO, path);
+        double rank_ms = run(nodes, SchedulingPolicy::CRITICAL_PATH, path);
+        printf("%4u | %5zu | %12ld | %12.0f | %9.2f | %9.2f | %4.2fx\n",
+               seed, nodes.size(), work, path, fifo_ms, rank_ms, fifo_ms / rank_ms);
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: Memory-bandwidth bound streaming, unpinned vs pinned workers with NUMA hints
+void benchmark_numa() {
+    const size_t TOTAL_BYTES = size_t(128) << 20;
+    const int NUM_PASSES = 10;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t num_chunks = std::max<size_t>(16, 4 * num_threads);
+    const size_t chunk_len = TOTAL_BYTES / sizeof(double) / num_chunks;
+
+    Topology topology;
+    std::cout << "Benchmark: NUMA Placement (" << (TOTAL_BYTES >> 20) << " MB, " << num_chunks
+              << " chunks, " << num_threads << " threads)\n";
+    for (const NumaNode& node : topology.nodes()) {
+        std::cout << "  node " << node.id << ": " << node.cpus.size() << " cpus\n";
+    }
+    std::cout << "Placement        | Time (ms) | GB/s\n";
+    std::cout << "-----------------|-----------|-------\n";
+
+    // every chunk is first touched and later summed by a task with the same hint,
+    // so with pinned workers its pages live on the node that reads them
+    auto run = [&](const char* name, const ThreadPoolOptions& options) {
+        TaskScheduler scheduler(num_threads, options);
+        size_t num_nodes = options.pin_workers ? topology.numNodes() : 1;
+        std::vector<std::unique_ptr<double[]>> chunks;
+        for (size_t c = 0; c < num_chunks; ++c) {
+            chunks.emplace_back(new double[chunk_len]); // not touched yet
+        }
+
+        auto submit_all = [&](auto make_work) {
+            for (size_t c = 0; c < num_chunks; ++c) {
+                Task* task = scheduler.createTask(c, make_work(chunks[c].get()));
+                if (options.pin_workers) {
+                    task->setNumaNode(static_cast<int>(c % num_nodes));
+                }
+                scheduler.submit(task);
+            }
+            scheduler.waitAll();
+        };
+
+        submit_all([&](double* data) {
+            return [data, chunk_len]() {
+                for (size_t i = 0; i < chunk_len; ++i) {
+                    data[i] = double(i);
+                }
+            };
+        });
+
+        std::atomic<long long> checksum{0};
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int pass = 0; pass < NUM_PASSES; ++pass) {
+            submit_all([&](double* data) {
+                return [data, chunk_len, &checksum]() {
+                    double sum = 0.0;
+                    for (size_t i = 0; i < chunk_len; ++i) {
+                        sum += data[i];
+                    }
+                    checksum.fetch_add(static_cast<long long>(sum), std::memory_order_relaxed);
+                };
+            });
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        double gb_per_sec = double(TOTAL_BYTES) * NUM_PASSES / (time_ms / 1000.0) / 1e9;
+        printf("%-16s | %9.1f | %6.2f\n", name, time_ms, gb_per_sec);
+    };
+
+    ThreadPoolOptions pinned;
+    pinned.pin_workers = true;
+    run("unpinned", ThreadPoolOptions{});
+    run("pinned + hints", pinned);
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: parallel_for / parallel_reduce / parallel_scan vs hand-chunked tasks and serial loops
+// (large: 100M elements instead of 10M, the scan then holds 800 MB)
+void benchmark_parallel_algorithms(bool large = false) {
+    const size_t N = large ? 100000000 : 10000000;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    TaskScheduler scheduler(num_threads);
+
+    std::cout << "Benchmark: Parallel Algorithms (" << N << " floats, " << num_threads << " threads)\n";
+    std::cout << "Operation | Variant         | Time (ms) | Result\n";
+    std::cout << "----------|-----------------|-----------|-------------\n";
+
+    auto time_ms = [](auto&& f) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    auto sum_range = [](const float* data, size_t lo, size_t hi, double acc) {
+        for (size_t i = lo; i < hi; ++i) {
+            acc += data[i];
+        }
+        return acc;
+    };
+
+    std::vector<float> data(N);
+
+    // fill
+    double ms = time_ms([&]() {
+        for (size_t i = 0; i < N; ++i) {
+            data[i] = float(i % 1000) * 0.001f;
+        }
+    });
+    printf("fill      | %-15s | %9.1f |\n", "serial", ms);
+    ms = time_ms([&]() {
+        parallel_for(scheduler, 0, N, [&data](size_t i) {
+            data[i] = float(i % 1000) * 0.001f;
+        });
+    });
+    printf("fill      | %-15s | %9.1f |\n", "parallel_for", ms);
+
+    // reduce
+    double result = 0.0;
+    ms = time_ms([&]() { result = sum_range(data.data(), 0, N, 0.0); });
+    printf("reduce    | %-15s | %9.1f | %.1f\n", "serial", ms, result);
+
+    ms = time_ms([&]() {
+        // baseline: one task per fixed chunk, results in per-chunk slots
+        const size_t num_chunks = num_threads * 4;
+        const size_t chunk = (N + num_chunks - 1) / num_chunks;
+        std::vector<CachePadded<double>> partials(num_chunks, CachePadded<double>(0.0));
+        TaskGroup group;
+        for (size_t c = 0; c < num_chunks; ++c) {
+            scheduler.submit([&, c]() {
+                partials[c].value = sum_range(data.data(), c * chunk, std::min(N, (c + 1) * chunk), 0.0);
+            }, group);
+        }
+        group.wait();
+        result = 0.0;
+        for (auto& partial : partials) {
+            result += partial.value;
+        }
+    });
+    printf("reduce    | %-15s | %9.1f | %.1f\n", "hand-chunked", ms, result);
+
+    ms = time_ms([&]() {
+        result = parallel_reduce(scheduler, 0, N, 0.0,
+            [&](size_t lo, size_t hi, double acc) { return sum_range(data.data(), lo, hi, acc); },
+            [](double a, double b) { return a + b; });
+    });
+    printf("reduce    | %-15s | %9.1f | %.1f\n", "parallel_reduce", ms, result);
+
+    // inclusive scan (in place); unsigned wrap-around keeps both results exact
+    data = std::vector<float>();
+    std::vector<uint32_t> values(N);
+    for (size_t i = 0; i < N; ++i) {
+        values[i] = uint32_t(i % 1000);
+    }
+    std::vector<uint32_t> copy = values;
+    ms = time_ms([&]() { std::partial_sum(copy.begin(), copy.end(), copy.begin()); });
+    printf("scan      | %-15s | %9.1f | %u\n", "serial", ms, copy.back());
+    ms = time_ms([&]() {
+        parallel_scan(scheduler, values.data(), values.data(), N, 0u, [](uint32_t a, uint32_t b) { return a + b; });
+    });
+    printf("scan      | %-15s | %9.1f | %u\n", "parallel_scan", ms, values.back());
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: per-run overhead of the benchmark_dag shape (10 -> 50 -> 10 -> 1),
+// rebuilt from scratch every run vs a TaskGraph built once and replayed
+void benchmark_task_graph() {
+    const int NUM_RUNS = 2000;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    TaskScheduler scheduler(num_threads);
+    std::atomic<int> result{0};
+    auto work = [&result]() {
+        result.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    // same wiring as benchmark_dag; add(work) returns a node, wire(node, dependency)
+    auto build = [](auto&& add, auto&& wire) {
+        std::vector<decltype(add())> layer1, layer2, layer3;
+        for (int i = 0; i < 10; ++i) {
+            layer1.push_back(add());
+        }
+        for (int i = 0; i < 50; ++i) {
+            auto node = add();
+            wire(node, layer1[i % 10]);
+            wire(node, layer1[(i + 1) % 10]);
+            layer2.push_back(node);
+        }
+        for (int i = 0; i < 10; ++i) {
+            auto node = add();
+            for (int j = i * 5; j < (i + 1) * 5; ++j) {
+                wire(node, layer2[j]);
+            }
+            layer3.push_back(node);
+        }
+        auto final_node = add();
+        for (auto node : layer3) {
+            wire(final_node, node);
+        }
+    };
+
+    std::cout << "Benchmark: Task Graph Replay (71 tasks, 160 edges, " << num_threads << " threads)\n";
+    std::cout << "Variant           | us/run | Allocations/run\n";
+    std::cout << "------------------|--------|----------------\n";
+
+    auto report = [&](const char* name, auto&& run_once) {
+        run_once(); // warm up pools and queues
+        size_t before = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int run = 0; run < NUM_RUNS; ++run) {
+            run_once();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        size_t allocations = g_allocations.load(std::memory_order_relaxed) - before;
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / NUM_RUNS;
+        printf("%-17s | %6.1f | %15.1f\n", name, us, double(allocations) / NUM_RUNS);
+    };
+
+    report("rebuild (owned)", [&]() {
+        uint64_t id = 0;
+        build([&]() {
+            auto task = std::make_unique<Task>(id++, work);
+            Task* raw = task.get();
+            scheduler.submit(std::move(task));
+            return raw;
+        }, [](Task* node, Task* dependency) {
+            node->addDependency(dependency);
+        });
+        scheduler.waitAll();
+    });
+
+    report("rebuild (pooled)", [&]() {
+        // pooled tasks must be wired before they are submitted
+        std::vector<Task*> tasks;
+        uint64_t id = 0;
+        build([&]() {
+            tasks.push_back(scheduler.createTask(id++, work));
+            return tasks.back();
+        }, [](Task* node, Task* dependency) {
+            node->addDependency(dependency);
+        });
+        scheduler.submitBatch(tasks);
+        scheduler.waitAll();
+    });
+
+    TaskGraph graph;
+    build([&]() {
+        return graph.addNode(work);
+    }, [&](size_t node, size_t dependency) {
+        graph.addDependency(node, dependency);
+    });
+    graph.freeze();
+    report("replay", [&]() {
+        scheduler.run(graph);
+    });
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: exception capture in Task::execute(). Tasks that do not throw pay nothing
+// for the try block (table-based unwinding); only throwing tasks take the slow path.
+void benchmark_failures() {
+    const int NUM_TASKS = 1000000;
+    const int WAVE = 100000;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    TaskScheduler scheduler(num_threads);
+    std::atomic<int> result{0};
+
+    std::cout << "Benchmark: Failure Handling (" << NUM_TASKS << " empty tasks, " << num_threads << " threads)\n";
+    std::cout << "Tasks that throw | Tasks/s (M) | Errors collected\n";
+    std::cout << "-----------------|-------------|-----------------\n";
+
+    for (int every : {0, 1000, 100}) {
+        size_t errors = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int wave = 0; wave < NUM_TASKS; wave += WAVE) {
+            for (int i = wave; i < wave + WAVE; ++i) {
+                scheduler.submit([&result, every, i]() {
+                    if (every > 0 && i % every == 0) {
+                        throw i;
+                    }
+                    result.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            try {
+                scheduler.waitAll();
+            } catch (int) {
+                errors += scheduler.getErrors().size();
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        printf("%-16s | %11.2f | %16zu\n", every == 0 ? "none" : (every == 1000 ? "0.1%" : "1%"),
+               NUM_TASKS / seconds / 1e6, errors);
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: aggregate submit() throughput of 1..32 threads feeding one scheduler at once
+// (empty tasks; owned unique_ptr tasks and tasks built in place in the pool)
+void benchmark_producers() {
+    const int TASKS_PER_PRODUCER = 200000 / 4;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Benchmark: Concurrent Producers (" << TASKS_PER_PRODUCER << " tasks per producer, "
+              << num_threads << " workers)\n";
+    std::cout << "Producers | unique_ptr (M tasks/s) | in place (M tasks/s)\n";
+    std::cout << "----------|------------------------|---------------------\n";
+
+    for (int producers : {1, 2, 4, 8, 16, 32}) {
+        double rates[2];
+        for (int in_place = 0; in_place < 2; ++in_place) {
+            TaskScheduler scheduler(num_threads);
+            std::atomic<int> started{0};
+            std::atomic<bool> go{false};
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&, p]() {
+                    started.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < TASKS_PER_PRODUCER; ++i) {
+                        if (in_place) {
+                            scheduler.submit([]() {});
+                        } else {
+                            scheduler.submit(std::make_unique<Task>(p * TASKS_PER_PRODUCER + i, []() {}));
+                        }
+                    }
+                });
+            }
+            while (started.load() < producers) {
+                std::this_thread::yield();
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            scheduler.waitAll();
+            auto end = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            rates[in_place] = producers * TASKS_PER_PRODUCER / seconds / 1e6;
+        }
+        printf("%9d | %22.2f | %20.2f\n", producers, rates[0], rates[1]);
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: a producer 10x faster than the workers, with and without admission limits.
+// Every task carries a 16 KB input buffer; unlimited, the backlog (and RSS) grows with
+// the burst, limited, the producer is stalled to the rate the workers keep up with.
+void benchmark_backpressure() {
+    const int NUM_TASKS = 10000;
+    const size_t PAYLOAD = 16 * 1024;
+    const auto CONSUME = std::chrono::microseconds(50);
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto PRODUCE = CONSUME / (10 * static_cast<int>(num_threads));
+    auto spin = [](std::chrono::steady_clock::duration duration) {
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end) {
+        }
+    };
+    // resident set size from /proc (0 where it is not available)
+    auto residentBytes = []() -> size_t {
+        size_t pages = 0;
+        size_t resident = 0;
+        if (FILE* file = std::fopen("/proc/self/statm", "r")) {
+            if (std::fscanf(file, "%zu %zu", &pages, &resident) != 2) {
+                resident = 0;
+            }
+            std::fclose(file);
+        }
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    };
+
+    std::cout << "Benchmark: Backpressure (" << NUM_TASKS << " tasks with " << PAYLOAD / 1024 << " KB each, "
+              << num_threads << " threads, producer 10x faster)\n";
+    std::cout << "Limit          | Peak RSS growth (MB) | Producer stall (ms) | Makespan (ms)\n";
+    std::cout << "---------------|----------------------|---------------------|--------------\n";
+
+    // limited first: freed buffers are not necessarily returned to the OS
+    for (size_t max_bytes : {64 * (PAYLOAD + sizeof(Task)), size_t(0)}) {
+        TaskScheduler scheduler(num_threads);
+        AdmissionLimits limits;
+        limits.max_bytes = max_bytes;
+        scheduler.setAdmissionLimits(limits);
+
+        size_t start_rss = residentBytes();
+        std::atomic<size_t> peak_rss{start_rss};
+        std::atomic<bool> sampling{true};
+        std::thread sampler([&]() {
+            while (sampling.load(std::memory_order_relaxed)) {
+                peak_rss.store(std::max(peak_rss.load(std::memory_order_relaxed), residentBytes()),
+                               std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        std::atomic<int> checksum{0};
+        std::chrono::steady_clock::duration stall{};
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_TASKS; ++i) {
+            spin(PRODUCE);
+            std::vector<char> input(PAYLOAD, static_cast<char>(i));
+            Task* task = scheduler.createTask(i, [input = std::move(input), &checksum, &spin, CONSUME]() {
+                spin(CONSUME);
+                checksum.fetch_add(input[0], std::memory_order_relaxed);
+            });
+            task->setMemoryEstimate(PAYLOAD);
+            auto before = std::chrono::steady_clock::now();
+            scheduler.submit(task);
+            stall += std::chrono::steady_clock::now() - before;
+        }
+        scheduler.waitAll();
+        auto end = std::chrono::steady_clock::now();
+        sampling = false;
+        sampler.join();
+
+        char label[32];
+        if (max_bytes == 0) {
+            std::snprintf(label, sizeof(label), "off");
+        } else {
+            std::snprintf(label, sizeof(label), "%zu KB", max_bytes / 1024);
+        }
+        printf("%-14s | %20.1f | %19.1f | %13.1f\n", label,
+               (peak_rss.load() - start_rss) / (1024.0 * 1024.0),
+               std::chrono::duration<double, std::milli>(stall).count(),
+               std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: cancelling a 1M-task subgraph (1000 layers of 1000, two dependencies per task)
+// vs running it with empty work; only submission until waitAll() / run() is timed
+void benchmark_cancellation() {
+    const size_t WIDTH = 1000;
+    const size_t LAYERS = 1000;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    TaskScheduler scheduler(num_threads);
+    std::atomic<size_t> ran{0};
+    auto work = [&ran]() {
+        ran.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    std::cout << "Benchmark: Cancelling a Subgraph (" << WIDTH * LAYERS + 1 << " tasks, "
+              << num_threads << " threads)\n";
+    std::cout << "Variant                    | Time (ms) | ns/task | Tasks run\n";
+    std::cout << "---------------------------|-----------|---------|----------\n";
+
+    // root -> layer 0 -> ... -> layer LAYERS-1; add(work) returns a node, wire(node, dependency)
+    auto build = [&](auto&& add, auto&& wire) {
+        auto root = add();
+        std::vector<decltype(root)> previous(WIDTH, root), current;
+        for (size_t layer = 0; layer < LAYERS; ++layer) {
+            current.clear();
+            for (size_t i = 0; i < WIDTH; ++i) {
+                auto node = add();
+                wire(node, previous[i]);
+                if (layer > 0) {
+                    wire(node, previous[(i + 1) % WIDTH]);
+                }
+                current.push_back(node);
+            }
+            previous.swap(current);
+        }
+        return root;
+    };
+    auto report = [&](const char* name, auto&& run_once) {
+        ran = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        run_once();
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        printf("%-26s | %9.1f | %7.1f | %9zu\n", name, ms, ms * 1e6 / (WIDTH * LAYERS + 1), ran.load());
+    };
+
+    for (bool cancel : {false, true}) {
+        std::vector<Task*> tasks;
+        tasks.reserve(WIDTH * LAYERS + 1);
+        Task* root = build([&]() {
+            tasks.push_back(scheduler.createTask(tasks.size(), work));
+            return tasks.back();
+        }, [](Task* node, Task* dependency) {
+            node->addDependency(dependency);
+        });
+        if (cancel) {
+            root->cancel();
+        }
+        report(cancel ? "tasks, root cancelled" : "tasks, run", [&]() {
+            scheduler.submitBatch(tasks);
+            scheduler.waitAll();
+        });
+    }
+
+    TaskGraph graph;
+    CancellationToken token;
+    size_t root = build([&]() {
+        return graph.addNode(work);
+    }, [&](size_t node, size_t dependency) {
+        graph.addDependency(node, dependency);
+    });
+    graph.task(root).setCancellationToken(&token);
+    scheduler.run(graph); // freeze outside the timing
+    report("graph replay, run", [&]() {
+        scheduler.run(graph);
+    });
+    token.cancel();
+    report("graph replay, root token", [&]() {
+        scheduler.run(graph);
+    });
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: cost of the built-in statistics on the benchmark_scaling workload
+// (stats compiled in but off vs on; the best of several runs is compared)
+void benchmark_stats_overhead() {
+    const int NUM_TASKS = 10000;
+    const int NUM_RUNS = 7;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto run = [&](bool collect, int work_iterations, SchedulerStats* stats) {
+        ThreadPoolOptions options;
+        options.collect_stats = collect;
+        TaskScheduler scheduler(num_threads, options);
+        std::atomic<int> counter{0};
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < NUM_TASKS; ++i) {
+            auto task = std::make_unique<Task>(i, [&counter, work_iterations]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+                volatile int x = 0;
+                for (int j = 0; j < work_iterations; ++j) {
+                    x += j;
+                }
+            });
+            scheduler.submit(std::move(task));
+        }
+        scheduler.waitAll();
+        auto end = std::chrono::high_resolution_clock::now();
+        if (stats) {
+            *stats = scheduler.getStats();
+        }
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    std::cout << "Benchmark: Statistics Overhead (10,000 tasks, " << num_threads << " threads)\n";
+    std::cout << "Work/task | Stats off (ms) | Stats on (ms) | Overhead\n";
+    std::cout << "----------|----------------|---------------|---------\n";
+
+    SchedulerStats stats;
+    for (int work_iterations : {10000, 100}) {
+        double best_off = 1e300, best_on = 1e300;
+        for (int i = 0; i < NUM_RUNS; ++i) {
+            best_off = std::min(best_off, run(false, work_iterations, nullptr));
+            best_on = std::min(best_on, run(true, work_iterations, &stats));
+        }
+        printf("%9d | %14.2f | %13.2f | %7.2f%%\n", work_iterations, best_off, best_on,
+               (best_on - best_off) / best_off * 100.0);
+    }
+
+    // what the last snapshot (short tasks) shows
+    const WorkerStatsSnapshot& total = stats.total;
+    printf("snapshot: %lu tasks, %lu local / %lu injected / %lu stolen, %lu parks, %lu of %lu locks contended\n",
+           (unsigned long)total.get(StatCounter::TASKS_EXECUTED), (unsigned long)total.get(StatCounter::LOCAL_POPS),
+           (unsigned long)total.get(StatCounter::INJECTED_POPS), (unsigned long)total.get(StatCounter::STEALS),
+           (unsigned long)total.get(StatCounter::PARKS), (unsigned long)total.get(StatCounter::LOCK_CONTENDED),
+           (unsigned long)total.get(StatCounter::LOCK_ACQUISITIONS));
+    printf("          queue wait p50 %lu ns, p99 %lu ns; run time p50 %lu ns; busy %.1f ms, idle %.1f ms\n\n",
+           (unsigned long)total.queue_wait.percentile(0.5), (unsigned long)total.queue_wait.percentile(0.99),
+           (unsigned long)total.run_time.percentile(0.5), total.get(StatCounter::BUSY_NS) / 1e6,
+           total.get(StatCounter::IDLE_NS) / 1e6);
+}
+
+
+
+// Benchmark: cost of recording a trace (task start/end, ready, steal, park events),
+// short independent tasks and replays of the benchmark_dag shape, best of several runs
+void benchmark_trace_overhead() {
+    const int NUM_TASKS = 10000;
+    const int NUM_REPLAYS = 200;
+    const int NUM_RUNS = 5;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto run = [&](bool traced, bool dag) {
+        ThreadPoolOptions options;
+        options.trace_events = traced ? (1 << 16) : 0;
+        TaskScheduler scheduler(num_threads, options);
+        std::atomic<int> counter{0};
+        auto work = [&counter]() {
+            counter.fetch_add(1, std::memory_order_relaxed);
+            volatile int x = 0;
+            for (int j = 0; j < 100; ++j) {
+                x += j;
+            }
+        };
+
+        TaskGraph graph;
+        if (dag) {
+            std::vector<size_t> layer1, layer2, layer3;
+            for (int i = 0; i < 10; ++i) {
+                layer1.push_back(graph.addNode(work));
+            }
+            for (int i = 0; i < 50; ++i) {
+                layer2.push_back(graph.addNode(work));
+                graph.addDependency(layer2.back(), layer1[i % 10]);
+                graph.addDependency(layer2.back(), layer1[(i + 1) % 10]);
+            }
+            for (int i = 0; i < 10; ++i) {
+                layer3.push_back(graph.addNode(work));
+                for (int j = i * 5; j < (i + 1) * 5; ++j) {
+                    graph.addDependency(layer3.back(), layer2[j]);
+                }
+            }
+            size_t final_node = graph.addNode(work);
+            for (size_t node : layer3) {
+                graph.addDependency(final_node, node);
+            }
+            graph.freeze();
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (dag) {
+            for (int i = 0; i < NUM_REPLAYS; ++i) {
+                scheduler.run(graph);
+            }
+        } else {
+            for (int i = 0; i < NUM_TASKS; ++i) {
+                scheduler.submit(work);
+            }
+            scheduler.waitAll();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    };
+
+    std::cout << "Benchmark: Trace Recording Overhead (" << num_threads << " threads)\n";
+    std::cout << "Workload              | Off (ns/task) | Traced (ns/task) | Overhead/task\n";
+    std::cout << "----------------------|---------------|------------------|--------------\n";
+    for (bool dag : {false, true}) {
+        double tasks = dag ? 71.0 * NUM_REPLAYS : NUM_TASKS;
+        double best_off = 1e300, best_on = 1e300;
+        for (int i = 0; i < NUM_RUNS; ++i) {
+            best_off = std::min(best_off, run(false, dag));
+            best_on = std::min(best_on, run(true, dag));
+        }
+        printf("%-21s | %13.1f | %16.1f | %10.1f ns\n", dag ? "DAG replay (71 tasks)" : "independent tasks",
+               best_off / tasks, best_on / tasks, (best_on - best_off) / tasks);
+    }
+    std::cout << "\n";
+}
+
+
+
+// Benchmark: DAG Processing -> Realistic Scenario
+// (with trace_path, the run is traced and written there as Chrome Trace JSON)
+void benchmark_dag(const char* trace_path = nullptr) {
+    std::cout << "Benchmark: DAG Processing (Realistic Workload)\n\n";
+    
+    ThreadPoolOptions options;
+    options.trace_events = trace_path ? 4096 : 0;
+    TaskScheduler scheduler(8, options);
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    // simulate workflow:
+    // Layer 1: 10 Data-Load Tasks
+    // Layer 2: 50 Processing Tasks (wait for layer 1)
+    // Layer 3: 10 Aggregation Tasks (wait for layer 2)
+    // Layer 4: 1 Final Task (wait for layer 3)
+    
+    std::vector<Task*> layer1, layer2, layer3;
+    std::atomic<int> result{0};
+    
+    // Layer 1: Load
+    for (int i = 0; i < 10; ++i) {
+        auto task = std::make_unique<Task>(i, [&result]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            result.fetch_add(1, std::memory_order_relaxed);
+        });
+        layer1.push_back(task.get());
+        scheduler.submit(std::move(task));
+    }
+    
+    // Layer 2: Process
+    for (int i = 0; i < 50; ++i) {
+        auto task = std::make_unique<Task>(10 + i, [&result]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            result.fetch_add(1, std::memory_order_relaxed);
+        });
+        
+        task->addDependency(layer1[i % 10]);
+        task->addDependency(layer1[(i + 1) % 10]);
+        
+        layer2.push_back(task.get());
+        scheduler.submit(std::move(task));
+    }
+    
+    // Layer 3: Aggregate
+    for (int i = 0; i < 10; ++i) {
         auto task = std::make_unique<Task>(60 + i, [&result]() {
             std::this_thread::sleep_for(std::chrono::microseconds(20));
             result.fetch_add(1, std::memory_order_relaxed);
@@ -363,21 +1770,337 @@ void benchmark_dag() {
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     
     std::cout << "Total time: " << duration.count() << " ms\n";
-    std::cout << "Tasks executed: " << result.load() << "\n\n";
+    std::cout << "Tasks executed: " << result.load() << "\n";
+    if (trace_path) {
+        bool written = scheduler.writeChromeTrace(trace_path);
+        std::cout << "Trace: " << scheduler.getTrace()->numEvents() << " events"
+                  << (written ? " written to " : " could not be written to ") << trace_path << "\n";
+    }
+    std::cout << "\n";
 }
 
 
 
-int main() {
+// a few hundred ns of work per stage of benchmark_dag_values
+static long mix(long value) {
+    for (int i = 0; i < 64; ++i) {
+        value = value * 6364136223846793005L + 1442695040888963407L;
+    }
+    return value;
+}
+
+// Benchmark: the benchmark_dag pipeline (10 loads -> 50 process -> 10 aggregate -> 1 final)
+// without sleeps, once with stage results in shared atomics and once with values passed
+// along the edges (TaskScheduler::submit(fn, inputs...)).
+void benchmark_dag_values() {
+    const int PIPELINES = 2000;
+    const int TASKS = 71;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Benchmark: DAG Values (" << PIPELINES << " pipelines x " << TASKS << " tasks, "
+              << num_threads << " threads)\n";
+    std::cout << "Data passing      | us / pipeline | Allocations / task | Checksum\n";
+    std::cout << "------------------|---------------|--------------------|---------------------\n";
+
+    TaskScheduler scheduler(num_threads);
+    for (int values = 0; values < 2; ++values) {
+        long checksum = 0;
+        size_t allocations_before = g_allocations.load();
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!values) {
+            // shared state: every stage publishes into an atomic its consumers read
+            std::vector<std::atomic<long>> load(10), process(50), aggregate(10);
+            std::atomic<long> result{0};
+            Task* layer1[10];
+            Task* layer2[50];
+            Task* layer3[10];
+            for (int pipeline = 0; pipeline < PIPELINES; ++pipeline) {
+                for (int i = 0; i < 10; ++i) {
+                    layer1[i] = scheduler.createTask(i, [&load, pipeline, i]() {
+                        load[i].store(mix(pipeline * 10 + i), std::memory_order_relaxed);
+                    });
+                }
+                for (int i = 0; i < 50; ++i) {
+                    layer2[i] = scheduler.createTask(10 + i, [&load, &process, i]() {
+                        process[i].store(mix(load[i % 10].load(std::memory_order_relaxed) ^
+                                             load[(i + 1) % 10].load(std::memory_order_relaxed)),
+                                         std::memory_order_relaxed);
+                    });
+                    layer2[i]->addDependency(layer1[i % 10]);
+                    layer2[i]->addDependency(layer1[(i + 1) % 10]);
+                }
+                for (int i = 0; i < 10; ++i) {
+                    layer3[i] = scheduler.createTask(60 + i, [&process, &aggregate, i]() {
+                        long sum = 0;
+                        for (int j = i * 5; j < (i + 1) * 5; ++j) {
+                            sum += process[j].load(std::memory_order_relaxed);
+                        }
+                        aggregate[i].store(mix(sum), std::memory_order_relaxed);
+                    });
+                    for (int j = i * 5; j < (i + 1) * 5; ++j) {
+                        layer3[i]->addDependency(layer2[j]);
+                    }
+                }
+                Task* final_task = scheduler.createTask(70, [&aggregate, &result]() {
+                    long sum = 0;
+                    for (auto& value : aggregate) {
+                        sum += value.load(std::memory_order_relaxed);
+                    }
+                    result.store(sum, std::memory_order_relaxed);
+                });
+                for (Task* task : layer3) {
+                    final_task->addDependency(task);
+                }
+                // one submit per task, like the value version
+                for (Task* task : layer1) {
+                    scheduler.submit(task);
+                }
+                for (Task* task : layer2) {
+                    scheduler.submit(task);
+                }
+                for (Task* task : layer3) {
+                    scheduler.submit(task);
+                }
+                scheduler.submit(final_task);
+                scheduler.waitAll();
+                checksum += result.load();
+            }
+        } else {
+            // values: every stage returns its result, consumers take them as arguments
+            TaskResult<long> layer1[10];
+            TaskResult<long> layer2[50];
+            TaskResult<long> layer3[10];
+            for (int pipeline = 0; pipeline < PIPELINES; ++pipeline) {
+                for (int i = 0; i < 10; ++i) {
+                    layer1[i] = scheduler.submit([pipeline, i]() { return mix(pipeline * 10 + i); });
+                }
+                for (int i = 0; i < 50; ++i) {
+                    layer2[i] = scheduler.submit([](long a, long b) { return mix(a ^ b); },
+                                                 layer1[i % 10], layer1[(i + 1) % 10]);
+                }
+                for (int i = 0; i < 10; ++i) {
+                    layer3[i] = scheduler.submit([](long a, long b, long c, long d, long e) {
+                        return mix(a + b + c + d + e);
+                    }, std::move(layer2[i * 5]), std::move(layer2[i * 5 + 1]), std::move(layer2[i * 5 + 2]),
+                       std::move(layer2[i * 5 + 3]), std::move(layer2[i * 5 + 4]));
+                }
+                TaskResult<long> result = scheduler.submit(
+                    [](long a, long b, long c, long d, long e, long f, long g, long h, long i, long j) {
+                        return a + b + c + d + e + f + g + h + i + j;
+                    }, std::move(layer3[0]), std::move(layer3[1]), std::move(layer3[2]), std::move(layer3[3]),
+                    std::move(layer3[4]), std::move(layer3[5]), std::move(layer3[6]), std::move(layer3[7]),
+                    std::move(layer3[8]), std::move(layer3[9]));
+                for (auto& handle : layer1) {
+                    handle.reset();
+                }
+                scheduler.waitAll();
+                checksum += result.get();
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double allocations = double(g_allocations.load() - allocations_before) / (PIPELINES * TASKS);
+        printf("%-17s | %13.1f | %18.2f | %20ld\n", values ? "values on edges" : "shared atomics",
+               std::chrono::duration<double, std::micro>(end - start).count() / PIPELINES, allocations, checksum);
+    }
+    std::cout << "\n";
+}
+
+
+// Benchmark: loads that read a chunk of a local temp file (plus a sleep standing in for the
+// device latency the page cache hides) feeding CPU-bound stages. Once with the loads on the
+// CPU workers like any task, once marked blocking (TaskScheduler::submitBlocking), so they
+// wait in the pool's BlockingLane while the workers process what already arrived.
+void benchmark_io_lane() {
+    const int CHUNKS = 64;
+    const size_t CHUNK_SIZE = 256 * 1024;
+    const auto DEVICE_LATENCY = std::chrono::milliseconds(2);
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    char path[] = "/tmp/benchmark_io_laneXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cout << "Benchmark: I/O Lane skipped (no temp file)\n\n";
+        return;
+    }
+    unlink(path);
+    std::vector<long> block(CHUNK_SIZE / sizeof(long));
+    for (int chunk = 0; chunk < CHUNKS; ++chunk) {
+        std::iota(block.begin(), block.end(), long(chunk) * long(block.size()));
+        if (pwrite(fd, block.data(), CHUNK_SIZE, off_t(chunk) * off_t(CHUNK_SIZE)) != ssize_t(CHUNK_SIZE)) {
+            close(fd);
+            std::cout << "Benchmark: I/O Lane skipped (write failed)\n\n";
+            return;
+        }
+    }
+
+    std::cout << "Benchmark: I/O Lane (" << CHUNKS << " reads of " << CHUNK_SIZE / 1024 << "KB + "
+              << DEVICE_LATENCY.count() << "ms latency -> CPU stage, " << num_threads << " threads)\n";
+    std::cout << "Loads run on      | Makespan (ms) | Lane threads | Checksum\n";
+    std::cout << "------------------|---------------|--------------|---------------------\n";
+
+    for (int split = 0; split < 2; ++split) {
+        TaskScheduler scheduler(num_threads);
+        auto load = [fd, CHUNK_SIZE, DEVICE_LATENCY](int chunk) {
+            return [fd, CHUNK_SIZE, DEVICE_LATENCY, chunk]() {
+                std::vector<long> data(CHUNK_SIZE / sizeof(long));
+                if (pread(fd, data.data(), CHUNK_SIZE, off_t(chunk) * off_t(CHUNK_SIZE)) != ssize_t(CHUNK_SIZE)) {
+                    data.clear();
+                }
+                std::this_thread::sleep_for(DEVICE_LATENCY);
+                return data;
+            };
+        };
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<TaskResult<long>> processed;
+        for (int chunk = 0; chunk < CHUNKS; ++chunk) {
+            TaskResult<std::vector<long>> data =
+                split ? scheduler.submitBlocking(load(chunk)) : scheduler.submit(load(chunk));
+            processed.push_back(scheduler.submit([](std::vector<long>&& data) {
+                long sum = 0;
+                for (long value : data) {
+                    sum += mix(value) >> 8;
+                }
+                return sum;
+            }, std::move(data)));
+        }
+        scheduler.waitAll();
+        long checksum = 0;
+        for (auto& result : processed) {
+            checksum += result.get();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        BlockingLane* lane = scheduler.getBlockingLane();
+        printf("%-17s | %13.1f | %12zu | %20ld\n", split ? "blocking lane" : "CPU workers",
+               std::chrono::duration<double, std::milli>(end - start).count(),
+               lane ? lane->peakThreads() : 0, checksum);
+    }
+    close(fd);
+    std::cout << "\n";
+}
+
+
+// Benchmark: startup of a 1M-node graph of kernel nodes (1000 layers of 1000, every node
+// waits for two of the layer before), rebuilt node by node as a TaskGraph vs mapped from a
+// snapshot file (GraphSnapshot). Load = until the graph can be run, first task = until the
+// first kernel started, both measured from the start of the load. The file is in the page
+// cache (written just before).
+void benchmark_snapshot() {
+    const uint32_t LAYERS = 1000;
+    const uint32_t WIDTH = 1000;
+    const size_t NODES = size_t(LAYERS) * WIDTH;
+    const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Benchmark: Graph Snapshot (" << NODES << " nodes, " << 2 * (NODES - WIDTH) << " edges, "
+              << num_threads << " threads)\n";
+    std::cout << "Graph from        | Load (ms) | First task (ms) | Run (ms) | Checksum\n";
+    std::cout << "------------------|-----------|-----------------|----------|-----------\n";
+
+    std::atomic<long> checksum{0};
+    std::atomic<bool> started{false};
+    std::chrono::high_resolution_clock::time_point first_task;
+    KernelRegistry registry;
+    registry.add(0, [&](const KernelParams& params) {
+        if (!started.load(std::memory_order_relaxed) && !started.exchange(true)) {
+            first_task = std::chrono::high_resolution_clock::now();
+        }
+        checksum.fetch_add(params.as<uint32_t>(), std::memory_order_relaxed);
+    });
+
+    char path[] = "/tmp/benchmark_snapshotXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cout << "skipped (no temp file)\n\n";
+        return;
+    }
+    close(fd);
+
+    TaskScheduler scheduler(num_threads);
+    auto ms = [](auto duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    for (int mapped = 0; mapped < 2; ++mapped) {
+        checksum = 0;
+        started = false;
+        auto start = std::chrono::high_resolution_clock::now();
+        std::chrono::high_resolution_clock::time_point loaded;
+        std::chrono::high_resolution_clock::time_point end;
+        if (!mapped) {
+            TaskGraph graph;
+            for (uint32_t layer = 0; layer < LAYERS; ++layer) {
+                for (uint32_t i = 0; i < WIDTH; ++i) {
+                    uint32_t param = i % 7;
+                    size_t node = graph.addNode(registry, 0, &param, sizeof(param));
+                    if (layer > 0) {
+                        graph.addDependency(node, node - WIDTH);
+                        graph.addDependency(node, node - WIDTH - i + (i * 31 + 1) % WIDTH);
+                    }
+                }
+            }
+            graph.freeze();
+            loaded = std::chrono::high_resolution_clock::now();
+            scheduler.run(graph);
+            end = std::chrono::high_resolution_clock::now();
+            // the mapped run loads what this run built
+            GraphSnapshot::write(graph, path);
+        } else {
+            GraphSnapshot snapshot;
+            if (!snapshot.open(path)) {
+                std::cout << "skipped (snapshot not readable)\n";
+                break;
+            }
+            loaded = std::chrono::high_resolution_clock::now();
+            scheduler.run(snapshot, registry);
+            end = std::chrono::high_resolution_clock::now();
+        }
+        printf("%-17s | %9.1f | %15.3f | %8.1f | %9ld\n", mapped ? "mmap snapshot" : "rebuild",
+               ms(loaded - start), ms(first_task - start), ms(end - loaded), checksum.load());
+    }
+    std::remove(path);
+    std::cout << "\n";
+}
+
+
+
+int main(int argc, char** argv) {
+    // ./benchmarks --dag-trace trace.json: only the DAG benchmark, traced
+    if (argc == 3 && std::string(argv[1]) == "--dag-trace") {
+        benchmark_dag(argv[2]);
+        return 0;
+    }
+    // ./benchmarks --cache-layout: only the Task layout benchmark (see benchmarks_packed_task)
+    if (argc == 2 && std::string(argv[1]) == "--cache-layout") {
+        benchmark_cache_layout();
+        return 0;
+    }
+    // ./benchmarks --large: everything, with the full sizes of the allocation and parallel benchmarks
+    bool large = (argc == 2 && std::string(argv[1]) == "--large");
+
     std::cout << "========================================\n";
     std::cout << "  Task Scheduler Performance Benchmarks\n";
     std::cout << "========================================\n\n";
     
     // run benchmarks
-    //benchmark_scaling();
-    //benchmark_latency();
+    benchmark_scaling();
+    benchmark_latency();
+    benchmark_latency_priority();
     benchmark_dependencies();
-    // benchmark_allocation();
+    benchmark_wakeup();
+    benchmark_wait();
+    benchmark_allocation(large);
+    benchmark_cache_layout();
+    benchmark_critical_path();
+    benchmark_numa();
+    benchmark_parallel_algorithms(large);
+    benchmark_task_graph();
+    benchmark_stats_overhead();
+    benchmark_trace_overhead();
+    benchmark_cancellation();
+    benchmark_producers();
+    benchmark_backpressure();
+    benchmark_dag_values();
+    benchmark_io_lane();
+    benchmark_snapshot();
+    benchmark_failures();
     // benchmark_dag();
     
     std::cout << "All benchmarks completed!\n";
@@ -3,6 +3,10 @@
 #include "task.h"
 #include <iostream>
 #include <cassert>
+#include <array>
+#include <exception>
+#include <functional>
+#include <memory>
 
 int main() {
     std::cout << "Test 1: Basic incrementation of a counter." << std::endl;
@@ -62,5 +66,50 @@ int main() {
     // Task copy = mathOperation; // triggers a compile error when uncommented
 
 
+    std::cout << "\nTest 4: Move-only and oversized callables." << std::endl;
+    auto boxed = std::make_unique<int>(7);
+    int result = 0;
+    Task moveOnly(6, [boxed = std::move(boxed), &result]() {result = *boxed; });
+
+    std::array<int, 32> big{}; // 128 bytes -> heap fallback
+    big[31] = 35;
+    Task oversized(7, [big, &result]() {result += big[31]; });
+
+    int callbacks = 0;
+    oversized.setOnCompleteCallback([&callbacks]([[maybe_unused]] Task* t) {
+        assert(t->getId() == 7);
+        callbacks++;
+    });
+
+    moveOnly.execute();
+    oversized.execute();
+
+    assert(result == 42);
+    assert(callbacks == 1);
+
+    // empty work fails the task instead of crashing the worker
+    Task empty(8, nullptr);
+    empty.execute();
+    assert(empty.getState() == TaskState::FAILED);
+    [[maybe_unused]] bool bad_call = false;
+    try {
+        std::rethrow_exception(empty.getError());
+    } catch (const std::bad_function_call&) {
+        bad_call = true;
+    }
+    assert(bad_call);
+
+    // so do a null function pointer and an empty std::function
+    void (*no_function)() = nullptr;
+    assert(!TaskWork(no_function) && !TaskWork(std::function<void()>()));
+    Task null_pointer(9, no_function);
+    null_pointer.execute();
+    assert(null_pointer.getState() == TaskState::FAILED);
+    Task empty_function(10, std::function<void()>());
+    empty_function.execute();
+    assert(empty_function.getState() == TaskState::FAILED);
+    std::cout << "✅ Test 4 passed" << std::endl;
+
+
     std::cout << "\n🎉 All tests passed!" << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+// tests/test_coroutines.cpp
+
+#include "coro_task.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+scheduler_task<long> fib(int n) {
+    if (n < 2) {
+        co_return n;
+    }
+    auto [a, b] = co_await whenAll(fib(n - 1), fib(n - 2));
+    co_return a + b;
+}
+
+scheduler_task<void> mergeSort(std::vector<int>& data, std::vector<int>& buffer, size_t begin, size_t end) {
+    if (end - begin <= 32) {
+        std::sort(data.begin() + begin, data.begin() + end);
+        co_return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    co_await whenAll(mergeSort(data, buffer, begin, middle), mergeSort(data, buffer, middle, end));
+    std::merge(data.begin() + begin, data.begin() + middle, data.begin() + middle, data.begin() + end,
+               buffer.begin() + begin);
+    std::copy(buffer.begin() + begin, buffer.begin() + end, data.begin() + begin);
+}
+
+scheduler_task<int> addOne(int value) {
+    co_return value + 1;
+}
+
+// sequential awaits: every child runs on the awaiting worker
+scheduler_task<int> chain(int length) {
+    int value = 0;
+    for (int i = 0; i < length; ++i) {
+        value = co_await addOne(value);
+    }
+    co_return value;
+}
+
+// nested awaits: every level waits on the next one
+scheduler_task<int> depth(int levels) {
+    if (levels == 0) {
+        co_return 0;
+    }
+    co_return 1 + co_await depth(levels - 1);
+}
+
+scheduler_task<int> failing() {
+    throw std::runtime_error("child failed");
+    co_return 0;
+}
+
+scheduler_task<int> catchChild() {
+    try {
+        auto [ok, never] = co_await whenAll(addOne(1), failing());
+        (void)ok;
+        (void)never;
+    } catch (const std::runtime_error&) {
+        co_return -1;
+    }
+    co_return 0;
+}
+
+int main() {
+    std::cout << "Test 1: Recursive fib with whenAll" << std::endl;
+    {
+        ThreadPool pool(4);
+        CoroutineRuntime runtime(pool);
+        assert(runtime.run(fib(20)) == 6765);
+        assert(runtime.run(fib(1)) == 1);
+    }
+    std::cout << "✅ Test 1 passed" << std::endl;
+
+
+    std::cout << "\nTest 2: Parallel merge sort" << std::endl;
+    {
+        ThreadPool pool(4, PoolMode::SHARED_QUEUE);
+        CoroutineRuntime runtime(pool);
+        std::vector<int> data(100000);
+        std::mt19937 rng(42);
+        for (int& value : data) {
+            value = static_cast<int>(rng() % 1000000);
+        }
+        std::vector<int> buffer(data.size());
+        runtime.run(mergeSort(data, buffer, 0, data.size()));
+        assert(std::is_sorted(data.begin(), data.end()));
+    }
+    std::cout << "✅ Test 2 passed" << std::endl;
+
+
+    std::cout << "\nTest 3: Sequential awaits and exceptions" << std::endl;
+    {
+        ThreadPool pool(2);
+        CoroutineRuntime runtime(pool);
+        assert(runtime.run(chain(100000)) == 100000);
+        assert(runtime.run(depth(1000000)) == 1000000);
+        assert(runtime.run(catchChild()) == -1);
+
+        [[maybe_unused]] bool thrown = false;
+        try {
+            runtime.run(failing());
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::cout << "✅ Test 3 passed" << std::endl;
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 // tests/test_dependencies.cpp
 
+#include "task_scheduler.h"
 #include "thread_pool.h"
 #include "task.h"
 
@@ -59,6 +60,80 @@ int main() {
     assert(data == 25);
     std::cout << "Done! data = " << data << std::endl;
     std::cout << "✅ Dependency test passed!" << std::endl;
-    
+
+
+    std::cout << "\nTest: Dependency on an already completed task is satisfied" << std::endl;
+
+    Task finished(4, []() {});
+    finished.execute();
+    Task late(5, []() {});
+    late.addDependency(&finished);
+    assert(late.isReady());
+    std::cout << "✅ Completed dependency test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Graph grows while its tasks execute" << std::endl;
+    {
+        TaskScheduler scheduler(4);
+        std::atomic<int> executed{0};
+        std::vector<Task*> submitted;
+
+        // every new task depends on the three previous ones, which may be pending,
+        // running or already completed when the edge is added
+        for (int i = 0; i < 5000; ++i) {
+            auto task = std::make_unique<Task>(i, [&executed]() {
+                executed.fetch_add(1, std::memory_order_relaxed);
+            });
+            for (int back = 1; back <= 3 && back <= i; ++back) {
+                task->addDependency(submitted[i - back]);
+            }
+            submitted.push_back(task.get());
+            scheduler.submit(std::move(task));
+        }
+        scheduler.waitAll();
+        assert(executed == 5000);
+    }
+    std::cout << "✅ Dynamic graph test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Critical path ranks order the ready tasks" << std::endl;
+    {
+        // root -> a -> a2 -> a3 (long branch), root -> b (short branch, heavier first task)
+        TaskScheduler scheduler(1);
+        scheduler.setSchedulingPolicy(SchedulingPolicy::CRITICAL_PATH);
+        std::vector<int> order;
+
+        auto make = [&order](int id) {
+            return std::make_unique<Task>(id, [&order, id]() { order.push_back(id); });
+        };
+        auto root = make(0);
+        auto a = make(1);
+        auto a2 = make(2);
+        auto a3 = make(3);
+        auto b = make(4);
+        b->setCost(2.0);
+        a->addDependency(root.get());
+        a2->addDependency(a.get());
+        a3->addDependency(a2.get());
+        b->addDependency(root.get());
+
+        computeUpwardRanks({root.get(), a.get(), a2.get(), a3.get(), b.get()});
+        assert(a3->getRank() == 1.0);
+        assert(a->getRank() == 3.0);
+        assert(b->getRank() == 2.0);
+        assert(root->getRank() == 4.0);
+
+        // root last: both branches are wired when it releases them
+        scheduler.submit(std::move(b));
+        scheduler.submit(std::move(a3));
+        scheduler.submit(std::move(a2));
+        scheduler.submit(std::move(a));
+        scheduler.submit(std::move(root));
+        scheduler.waitAll();
+
+        assert((order == std::vector<int>{0, 1, 4, 2, 3}));
+    }
+    std::cout << "✅ Critical path test passed!" << std::endl;
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+// tests/test_parallel.cpp
+
+#include "parallel_algorithms.h"
+#include "task_scheduler.h"
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+int main() {
+    std::cout << "Test 1: parallel_for visits every index once" << std::endl;
+    {
+        TaskScheduler scheduler(4);
+        std::vector<int> visits(100003, 0);
+        parallel_for(scheduler, 0, visits.size(), [&visits](size_t i) {
+            visits[i] += 1;
+        });
+        assert(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+
+        // range form with a tiny grain: many splits
+        std::vector<int> squares(1000, 0);
+        parallel_for(scheduler, 0, squares.size(), [&squares](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                squares[i] = static_cast<int>(i * i);
+            }
+        }, 1);
+        for (size_t i = 0; i < squares.size(); ++i) {
+            assert(squares[i] == static_cast<int>(i * i));
+        }
+
+        // empty range
+        parallel_for(scheduler, 5, 5, [](size_t) { assert(false); });
+    }
+    std::cout << "✅ Test 1 passed" << std::endl;
+
+
+    std::cout << "\nTest 2: parallel_reduce" << std::endl;
+    for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+        TaskScheduler scheduler(4, mode);
+        const size_t n = 1000000;
+        [[maybe_unused]] long long sum = parallel_reduce(scheduler, 0, n, 0LL,
+            [](size_t lo, size_t hi, long long acc) {
+                for (size_t i = lo; i < hi; ++i) {
+                    acc += static_cast<long long>(i);
+                }
+                return acc;
+            },
+            [](long long a, long long b) { return a + b; });
+        assert(sum == static_cast<long long>(n) * (n - 1) / 2);
+
+        [[maybe_unused]] int maximum = parallel_reduce(scheduler, 0, 777, -1,
+            [](size_t, size_t hi, int acc) { return std::max(acc, static_cast<int>(hi) - 1); },
+            [](int a, int b) { return std::max(a, b); }, 10);
+        assert(maximum == 776);
+    }
+    std::cout << "✅ Test 2 passed" << std::endl;
+
+
+    std::cout << "\nTest 3: parallel_scan" << std::endl;
+    {
+        TaskScheduler scheduler(3);
+        for (size_t n : {size_t(1), size_t(7), size_t(100000)}) {
+            std::vector<long long> in(n), out(n), expected(n);
+            for (size_t i = 0; i < n; ++i) {
+                in[i] = static_cast<long long>(i % 13) - 6;
+            }
+            std::partial_sum(in.begin(), in.end(), expected.begin());
+            parallel_scan(scheduler, in.data(), out.data(), n, 0LL,
+                          [](long long a, long long b) { return a + b; });
+            assert(out == expected);
+
+            // in place
+            parallel_scan(scheduler, in.data(), in.data(), n, 0LL,
+                          [](long long a, long long b) { return a + b; });
+            assert(in == expected);
+        }
+
+        // chunks are combined in index order: "last non-zero so far" is not commutative
+        const size_t n = 10000;
+        std::vector<int> in(n), out(n), expected(n);
+        for (size_t i = 0; i < n; ++i) {
+            in[i] = i % 7 == 0 ? static_cast<int>(i) : 0;
+        }
+        auto last_set = [](int a, int b) { return b != 0 ? b : a; };
+        std::partial_sum(in.begin(), in.end(), expected.begin(), last_set);
+        parallel_scan(scheduler, in.data(), out.data(), n, 0, last_set, 3);
+        assert(out == expected);
+    }
+    std::cout << "✅ Test 3 passed" << std::endl;
+
+
+    std::cout << "\nTest 4: A throwing body stops the loop and reaches the caller" << std::endl;
+    {
+        TaskScheduler scheduler(4);
+        std::atomic<size_t> calls{0};
+        [[maybe_unused]] bool thrown = false;
+        try {
+            parallel_for(scheduler, 0, 100000, [&calls](size_t i) {
+                calls.fetch_add(1, std::memory_order_relaxed);
+                if (i == 10) {
+                    throw std::runtime_error("body failed");
+                }
+            }, 100);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown && calls.load() < 100000);
+
+        thrown = false;
+        try {
+            parallel_reduce(scheduler, 0, 100000, 0LL,
+                [](size_t lo, size_t hi, long long acc) {
+                    if (lo <= 500 && 500 < hi) {
+                        throw std::runtime_error("range failed");
+                    }
+                    return acc + static_cast<long long>(hi - lo);
+                },
+                [](long long a, long long b) { return a + b; }, 100);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        std::vector<int> in(10000, 1), out(10000, 0);
+        try {
+            parallel_scan(scheduler, in.data(), out.data(), in.size(), 0, [](int a, int b) {
+                if (a == 5000) {
+                    throw std::runtime_error("combine failed");
+                }
+                return a + b;
+            }, 100);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // the failures belong to the loops, not to the scheduler's next wait
+        scheduler.waitAll();
+        assert(scheduler.getErrors().empty());
+    }
+    std::cout << "✅ Test 4 passed" << std::endl;
+
+    return 0;
+}
@@ -2,7 +2,23 @@
 
 #include "task_scheduler.h"
 #include <iostream>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
 
 
 int main() {
@@ -40,5 +56,1047 @@ int main() {
     assert(data == 25);
     
     std::cout << "✅ Scheduler test passed! data = " << data << std::endl;
+
+
+    std::cout << "\nTest: Task groups wait only for their own tasks" << std::endl;
+
+    TaskGroup fast_group;
+    TaskGroup slow_group;
+    std::atomic<bool> release_slow{false};
+    std::atomic<int> fast_done{0};
+
+    // slow tasks block until the fast group has been waited for
+    for (int i = 0; i < 2; ++i) {
+        scheduler.submit(std::make_unique<Task>(100 + i, [&release_slow]() {
+            while (!release_slow.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }), slow_group);
+    }
+    for (int i = 0; i < 50; ++i) {
+        scheduler.submit(std::make_unique<Task>(200 + i, [&fast_done]() {
+            fast_done.fetch_add(1, std::memory_order_relaxed);
+        }), fast_group);
+    }
+
+    fast_group.wait();
+    assert(fast_done == 50);
+    assert(slow_group.pending() == 2);
+
+    release_slow.store(true, std::memory_order_release);
+    slow_group.wait();
+    scheduler.waitAll();
+    assert(slow_group.pending() == 0);
+
+    std::cout << "✅ Task group test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Pooled tasks are recycled after completion" << std::endl;
+
+    std::atomic<int> pooled_sum{0};
+    for (int round = 0; round < 10; ++round) {
+        // wire the chain first, then submit (pooled tasks must not be touched after submit)
+        std::vector<Task*> chain;
+        for (int i = 0; i < 100; ++i) {
+            chain.push_back(scheduler.createTask(i, [&pooled_sum, i]() {
+                pooled_sum.fetch_add(i, std::memory_order_relaxed);
+            }));
+            if (i > 0) {
+                chain[i]->addDependency(chain[i - 1]);
+            }
+        }
+        for (Task* task : chain) {
+            scheduler.submit(task);
+        }
+        scheduler.waitAll();
+    }
+    assert(pooled_sum == 10 * 4950);
+
+    // tasks built in place from plain lambdas
+    TaskGroup lambda_group;
+    for (int i = 0; i < 100; ++i) {
+        scheduler.submit([&pooled_sum]() {
+            pooled_sum.fetch_add(1, std::memory_order_relaxed);
+        }, lambda_group);
+    }
+    lambda_group.wait();
+    assert(pooled_sum == 10 * 4950 + 100);
+
+    std::cout << "✅ Pooled task test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Batched submission of tasks and graphs" << std::endl;
+
+    std::atomic<int> batch_count{0};
+    auto count_one = [&batch_count]() {
+        batch_count.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    // independent pooled tasks in one batch
+    std::vector<Task*> batch;
+    for (int i = 0; i < 10000; ++i) {
+        batch.push_back(scheduler.createTask(i, count_one));
+    }
+    scheduler.submitBatch(batch);
+    scheduler.waitAll();
+    assert(batch_count == 10000);
+
+    // owned diamond graphs (a -> b, c -> d), ranked and submitted in one call each
+    for (SchedulingPolicy policy : {SchedulingPolicy::FIFO, SchedulingPolicy::CRITICAL_PATH}) {
+        scheduler.setSchedulingPolicy(policy);
+        std::vector<std::unique_ptr<Task>> graph;
+        int steps[4] = {};
+        std::atomic<int> num_steps{0};
+        for (int i = 0; i < 4; ++i) {
+            graph.push_back(std::make_unique<Task>(i, [&steps, &num_steps, i]() {
+                steps[num_steps.fetch_add(1)] = i;
+            }));
+        }
+        graph[1]->addDependency(graph[0].get());
+        graph[2]->addDependency(graph[0].get());
+        graph[3]->addDependency(graph[1].get());
+        graph[3]->addDependency(graph[2].get());
+        scheduler.submitGraph(std::move(graph));
+        scheduler.waitAll();
+        assert(num_steps == 4 && steps[0] == 0 && steps[3] == 3);
+    }
+    scheduler.setSchedulingPolicy(SchedulingPolicy::FIFO);
+
+    std::cout << "✅ Batch submission test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Reusable task graph" << std::endl;
+
+    // layered graph: 4 sources -> 8 workers -> 1 sink, replayed many times.
+    // runs[i] counts the runs of node i; a node must start after its dependencies' run.
+    TaskGraph graph;
+    std::atomic<int> runs[14] = {};
+    std::atomic<bool> order_ok{true};
+    auto node_work = [&runs, &order_ok](size_t self, std::vector<size_t> deps) {
+        return [&runs, &order_ok, self, deps = std::make_shared<std::vector<size_t>>(std::move(deps))]() {
+            for (size_t dep : *deps) {
+                if (runs[dep].load() != runs[self].load() + 1) {
+                    order_ok = false;
+                }
+            }
+            runs[self].fetch_add(1);
+        };
+    };
+    std::vector<size_t> sources, workers;
+    for (size_t i = 0; i < 4; ++i) {
+        sources.push_back(graph.addNode(node_work(i, {})));
+    }
+    for (size_t i = 0; i < 8; ++i) {
+        size_t node = graph.addNode(node_work(4 + i, {sources[i % 4], sources[(i + 1) % 4]}));
+        graph.addDependency(node, sources[i % 4]);
+        graph.addDependency(node, sources[(i + 1) % 4]);
+        workers.push_back(node);
+    }
+    size_t sink = graph.addNode(node_work(12, workers));
+    for (size_t node : workers) {
+        graph.addDependency(sink, node);
+    }
+    assert(graph.freeze() && graph.size() == 13 && graph.numEdges() == 24);
+    assert(graph.task(sink).getRank() == 1.0 && graph.task(sources[0]).getRank() == 3.0);
+
+    for (SchedulingPolicy policy : {SchedulingPolicy::FIFO, SchedulingPolicy::CRITICAL_PATH}) {
+        scheduler.setSchedulingPolicy(policy);
+        for (int run = 0; run < 200; ++run) {
+            assert(scheduler.run(graph));
+        }
+    }
+    scheduler.setSchedulingPolicy(SchedulingPolicy::FIFO);
+    assert(order_ok);
+    for (int i = 0; i < 13; ++i) {
+        assert(runs[i] == 400);
+    }
+
+    // nodes added after freeze() keep the existing edges
+    size_t tail = graph.addNode(node_work(13, {sink}));
+    graph.addDependency(tail, sink);
+    runs[13] = 400;
+    assert(scheduler.run(graph) && graph.numEdges() == 25);
+    assert(order_ok && runs[13] == 401);
+
+    // a cycle is rejected and nothing runs
+    TaskGraph cyclic;
+    size_t a = cyclic.addNode([&runs]() { runs[0].fetch_add(1); });
+    size_t b = cyclic.addNode([&runs]() { runs[0].fetch_add(1); });
+    cyclic.addDependency(a, b);
+    cyclic.addDependency(b, a);
+    assert(!scheduler.run(cyclic));
+    assert(runs[0] == 401);
+
+    // CRITICAL_PATH replays: every ready node goes out as a pooled token in one external
+    // batch over all classes; a token run and recycled while later classes are still being
+    // pushed must not go out again (each node runs exactly once per replay)
+    TaskGraph classes;
+    std::atomic<int> class_runs[48] = {};
+    for (size_t i = 0; i < 48; ++i) {
+        size_t node = classes.addNode([&class_runs, i]() { class_runs[i].fetch_add(1); });
+        classes.task(node).setPriority(static_cast<TaskPriority>(i % NUM_PRIORITIES));
+        if (i >= 40) {
+            classes.addDependency(node, i - 40);
+        }
+    }
+    scheduler.setSchedulingPolicy(SchedulingPolicy::CRITICAL_PATH);
+    for (int run = 0; run < 500; ++run) {
+        assert(scheduler.run(classes));
+    }
+    scheduler.setSchedulingPolicy(SchedulingPolicy::FIFO);
+    for (const auto& count : class_runs) {
+        assert(count == 500);
+    }
+
+    std::cout << "✅ Task graph test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Execution trace" << std::endl;
+
+    // the ring keeps the newest events
+    TraceBuffer ring(3);
+    for (uint64_t i = 0; i < 10; ++i) {
+        ring.record(TraceEventType::TASK_START, i);
+    }
+    uint64_t oldest = 0;
+    ring.forEach([&oldest](const TraceEvent& event) {
+        if (oldest == 0) {
+            oldest = event.task_id;
+        }
+    });
+    assert(ring.capacity() == 4 && ring.size() == 4 && ring.dropped() == 6 && oldest == 6);
+
+    {
+        ThreadPoolOptions options;
+        options.trace_events = 1024;
+        TaskScheduler traced(2, options);
+        TaskGraph diamond;
+        size_t top = diamond.addNode([]() {});
+        size_t left = diamond.addNode([]() {});
+        size_t right = diamond.addNode([]() {});
+        size_t bottom = diamond.addNode([]() {});
+        diamond.addDependency(left, top);
+        diamond.addDependency(right, top);
+        diamond.addDependency(bottom, left);
+        diamond.addDependency(bottom, right);
+        assert(traced.run(diamond));
+
+        // start and end per task, and one READY per released dependent (from a worker);
+        // the last end is recorded after run() returned, so poll for it
+        size_t starts = 0, ends = 0, ready = 0;
+        TraceRecorder* trace = traced.getTrace();
+        while (ends < 4) {
+            starts = ends = ready = 0;
+            for (size_t w = 0; w < trace->numWorkers(); ++w) {
+                trace->buffer(w).forEach([&](const TraceEvent& event) {
+                    starts += event.type == TraceEventType::TASK_START;
+                    ends += event.type == TraceEventType::TASK_END;
+                    ready += event.type == TraceEventType::READY;
+                });
+            }
+            std::this_thread::yield();
+        }
+        assert(starts == 4 && ends == 4 && ready == 3);
+
+        std::ostringstream json;
+        trace->writeChromeTrace(json);
+        assert(json.str().find("\"traceEvents\"") != std::string::npos);
+        assert(json.str().find("\"name\":\"task 3\"") != std::string::npos);
+
+        // switched off: no more tasks are recorded (a parked worker still logs its wakeup)
+        traced.setTracing(false);
+        trace->clear();
+        assert(traced.run(diamond));
+        starts = 0;
+        for (size_t w = 0; w < trace->numWorkers(); ++w) {
+            trace->buffer(w).forEach([&starts](const TraceEvent& event) {
+                starts += event.type == TraceEventType::TASK_START;
+            });
+        }
+        assert(starts == 0);
+    }
+
+    // CRITICAL_PATH: dispatch tokens keep the priority of their task, and the trace names the
+    // task a token actually ran (the highest ranked one), not the one that created the token
+    {
+        ThreadPoolOptions options;
+        options.trace_events = 1024;
+        TaskScheduler ranked(1, options);
+        ranked.setSchedulingPolicy(SchedulingPolicy::CRITICAL_PATH);
+        std::atomic<bool> gate_running{false}, gate_released{false};
+        std::mutex order_mutex;
+        std::vector<uint64_t> order;
+        auto record = [&order_mutex, &order](uint64_t id) {
+            return [&order_mutex, &order, id]() {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(id);
+            };
+        };
+        ranked.submit(ranked.createTask(100, [&gate_running, &gate_released]() {
+            gate_running = true;
+            while (!gate_released) {
+                std::this_thread::yield();
+            }
+        }));
+        while (!gate_running) {
+            std::this_thread::yield();
+        }
+        Task* low_rank = ranked.createTask(1, record(1));
+        low_rank->setRank(1.0);
+        Task* high_rank = ranked.createTask(2, record(2));
+        high_rank->setRank(10.0);
+        Task* urgent = ranked.createTask(3, record(3));
+        urgent->setRank(0.5);
+        urgent->setPriority(TaskPriority::HIGH);
+        ranked.submit(low_rank);
+        ranked.submit(high_rank);
+        ranked.submit(urgent);
+        gate_released = true;
+        ranked.waitAll();
+        assert((order == std::vector<uint64_t>{3, 2, 1}));
+
+        std::vector<uint64_t> started;
+        TraceRecorder* trace = ranked.getTrace();
+        while (started.size() < 4) {
+            started.clear();
+            trace->buffer(0).forEach([&started](const TraceEvent& event) {
+                if (event.type == TraceEventType::TASK_START) {
+                    started.push_back(event.task_id);
+                }
+            });
+            std::this_thread::yield();
+        }
+        assert((started == std::vector<uint64_t>{100, 3, 2, 1}));
+    }
+
+    std::cout << "✅ Execution trace test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Cancellation and deadlines" << std::endl;
+
+    // a cancelled task cancels its transitive dependents, unrelated tasks still run
+    std::atomic<int> ran{0};
+    auto count_run = [&ran]() { ran.fetch_add(1); };
+    auto load = std::make_unique<Task>(1, count_run);
+    auto parse = std::make_unique<Task>(2, count_run);
+    auto check = std::make_unique<Task>(3, count_run);
+    auto report = std::make_unique<Task>(4, count_run);
+    auto other = std::make_unique<Task>(5, count_run);
+    parse->addDependency(load.get());
+    check->addDependency(parse.get());
+    report->addDependency(check.get());
+    report->addDependency(other.get());
+    parse->cancel();
+    Task* states[] = {load.get(), parse.get(), check.get(), report.get(), other.get()};
+    scheduler.submit(std::move(load));
+    scheduler.submit(std::move(parse));
+    scheduler.submit(std::move(check));
+    scheduler.submit(std::move(report));
+    scheduler.submit(std::move(other));
+    // (owned tasks live until waitAll(), so poll their states first)
+    while (states[0]->getState() != TaskState::COMPLETED || states[3]->getState() != TaskState::CANCELLED) {
+        std::this_thread::yield();
+    }
+    assert(states[1]->getState() == TaskState::CANCELLED && states[2]->getState() == TaskState::CANCELLED);
+    assert(states[4]->getState() == TaskState::COMPLETED);
+    scheduler.waitAll();
+    assert(ran == 2);
+
+    // an edge added after the dependency finished still cancels the dependent if that
+    // dependency was cancelled or failed (no owner: its dependents are skipped)
+    ran = 0;
+    Task cancelled_early(6, count_run);
+    cancelled_early.cancel();
+    cancelled_early.execute();
+    Task failed_early(7, []() { throw std::runtime_error("late edge"); });
+    failed_early.execute();
+    Task finished_early(8, count_run);
+    finished_early.execute();
+    assert(cancelled_early.getState() == TaskState::CANCELLED && failed_early.getState() == TaskState::FAILED);
+    Task* after_cancelled = scheduler.createTask(9, count_run);
+    after_cancelled->addDependency(&cancelled_early);
+    Task* after_failed = scheduler.createTask(10, count_run);
+    after_failed->addDependency(&failed_early);
+    Task* after_finished = scheduler.createTask(11, count_run);
+    after_finished->addDependency(&finished_early);
+    scheduler.submitBatch(std::vector<Task*>{after_cancelled, after_failed, after_finished});
+    scheduler.waitAll();
+    assert(ran == 2);
+
+    // a token cancelled by a running task stops the tasks waiting for it
+    ran = 0;
+    CancellationToken flow;
+    Task* gate = scheduler.createTask(0, [&flow]() { flow.cancel(); });
+    std::vector<Task*> fan = {gate};
+    for (uint64_t i = 1; i <= 100; ++i) {
+        fan.push_back(scheduler.createTask(i, count_run));
+        fan.back()->addDependency(gate);
+        fan.back()->setCancellationToken(&flow);
+    }
+    scheduler.submitBatch(fan);
+    scheduler.waitAll();
+    assert(ran == 0 && flow.isCancelled());
+    flow.reset();
+
+    // deadlines: an expired task is skipped, a task within its deadline runs
+    auto expired = std::make_unique<Task>(1, count_run);
+    expired->setDeadline(std::chrono::steady_clock::now() - std::chrono::milliseconds(1));
+    auto in_time = std::make_unique<Task>(2, count_run);
+    in_time->setDeadline(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    scheduler.submit(std::move(expired));
+    scheduler.submit(std::move(in_time));
+    scheduler.waitAll();
+    assert(ran == 1);
+
+    // a deep cancelled chain is pruned without recursion and waitAll() returns
+    ran = 0;
+    std::vector<Task*> chain;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        chain.push_back(scheduler.createTask(i, count_run));
+        if (i > 0) {
+            chain.back()->addDependency(chain[i - 1]);
+        }
+    }
+    chain[1]->cancel();
+    scheduler.submitBatch(chain);
+    scheduler.waitAll();
+    assert(ran == 1);
+
+    // task graphs: a cancelled node skips its successors for the runs that see the token
+    ran = 0;
+    TaskGraph pipeline;
+    size_t first = pipeline.addNode(count_run);
+    size_t middle = pipeline.addNode(count_run);
+    size_t last = pipeline.addNode(count_run);
+    pipeline.addDependency(middle, first);
+    pipeline.addDependency(last, middle);
+    pipeline.task(middle).setCancellationToken(&flow);
+    flow.cancel();
+    assert(scheduler.run(pipeline) && ran == 1);
+    assert(pipeline.task(last).getState() == TaskState::CANCELLED);
+    flow.reset();
+    assert(scheduler.run(pipeline) && ran == 4);
+
+    std::cout << "✅ Cancellation test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Exceptions and failure policies" << std::endl;
+
+    // a throwing task fails alone, the workers survive and waitAll() rethrows
+    for (FailurePolicy policy : {FailurePolicy::SKIP_DEPENDENTS, FailurePolicy::RUN_DEPENDENTS}) {
+        scheduler.setFailurePolicy(policy);
+        ran = 0;
+        auto fetch = std::make_unique<Task>(1, count_run);
+        auto compile = std::make_unique<Task>(2, []() { throw std::runtime_error("compile failed"); });
+        auto link = std::make_unique<Task>(3, count_run);
+        auto package = std::make_unique<Task>(4, count_run);
+        compile->addDependency(fetch.get());
+        link->addDependency(compile.get());
+        package->addDependency(link.get());
+        Task* failed = compile.get();
+        scheduler.submit(std::move(fetch));
+        scheduler.submit(std::move(compile));
+        scheduler.submit(std::move(link));
+        scheduler.submit(std::move(package));
+        while (failed->getState() != TaskState::FAILED) {
+            std::this_thread::yield();
+        }
+        assert(failed->getError() != nullptr);
+
+        [[maybe_unused]] bool caught = false;
+        try {
+            scheduler.waitAll();
+        } catch (const std::runtime_error& error) {
+            caught = std::string(error.what()) == "compile failed";
+        }
+        assert(caught && scheduler.getErrors().size() == 1 && scheduler.getErrors()[0].task_id == 2);
+        assert(ran == (policy == FailurePolicy::SKIP_DEPENDENTS ? 1 : 3));
+    }
+    scheduler.setFailurePolicy(FailurePolicy::SKIP_DEPENDENTS);
+
+    // every failure is collected, the next wait starts clean
+    ran = 0;
+    for (int i = 0; i < 100; ++i) {
+        scheduler.submit([i, &ran]() {
+            if (i % 10 == 0) {
+                throw i;
+            }
+            ran.fetch_add(1);
+        });
+    }
+    [[maybe_unused]] bool threw = false;
+    try {
+        scheduler.waitAll();
+    } catch (int) {
+        threw = true;
+    }
+    assert(threw && scheduler.getErrors().size() == 10 && ran == 90);
+    scheduler.submit(count_run);
+    scheduler.waitAll();
+    assert(ran == 91);
+
+    // task graphs: run() rethrows, the failed node's successors are skipped for that run
+    std::atomic<bool> fail_middle{true};
+    TaskGraph flaky;
+    size_t head = flaky.addNode(count_run);
+    size_t step = flaky.addNode([&fail_middle, &ran]() {
+        if (fail_middle) {
+            throw std::runtime_error("flaky");
+        }
+        ran.fetch_add(1);
+    });
+    size_t end = flaky.addNode(count_run);
+    flaky.addDependency(step, head);
+    flaky.addDependency(end, step);
+    ran = 0;
+    threw = false;
+    try {
+        scheduler.run(flaky);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && ran == 1 && flaky.task(step).getState() == TaskState::FAILED);
+    fail_middle = false;
+    assert(scheduler.run(flaky) && ran == 4);
+
+    // every wait reports its own failures: a graph run leaves a loose task's failure to
+    // waitAll(), another thread's waitAll() leaves it alone, and wait(group) takes the group's
+    TaskGroup loose_group; // only waited for, group.wait() reports nothing
+    scheduler.submit([]() { throw std::runtime_error("loose"); }, loose_group);
+    loose_group.wait();
+    assert(scheduler.run(flaky));
+    std::thread([&scheduler]() {
+        scheduler.waitAll();
+        assert(scheduler.getErrors().empty());
+    }).join();
+    TaskGroup failing_group;
+    scheduler.submit([]() { throw std::logic_error("grouped"); }, failing_group);
+    [[maybe_unused]] bool grouped = false;
+    try {
+        scheduler.wait(failing_group);
+    } catch (const std::logic_error&) {
+        grouped = true;
+    }
+    assert(grouped && scheduler.getErrors().size() == 1);
+    threw = false;
+    try {
+        scheduler.waitAll();
+    } catch (const std::runtime_error& error) {
+        threw = std::string(error.what()) == "loose";
+    }
+    assert(threw && scheduler.getErrors().size() == 1);
+    scheduler.waitAll();
+
+    std::cout << "✅ Failure handling test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Concurrent producers" << std::endl;
+
+    // several threads submit owned, pooled and in-place tasks (with dependencies) at once
+    ran = 0;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 8; ++p) {
+        producers.emplace_back([&scheduler, &count_run]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto owned = std::make_unique<Task>(i, count_run);
+                Task* pooled = scheduler.createTask(i, count_run);
+                pooled->addDependency(owned.get());
+                scheduler.submit(std::move(owned));
+                scheduler.submit(pooled);
+                scheduler.submit(count_run);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    scheduler.waitAll();
+    assert(ran == 8 * 3000);
+
+    // waitAll() while another thread keeps submitting leaves that thread's tasks alone
+    ran = 0;
+    std::atomic<bool> producing{true};
+    std::thread producer([&]() {
+        for (int i = 0; i < 20000; ++i) {
+            scheduler.submit(std::make_unique<Task>(i, count_run));
+        }
+        producing = false;
+    });
+    while (producing) {
+        scheduler.waitAll();
+    }
+    producer.join();
+    scheduler.waitAll();
+    assert(ran == 20000);
+
+    // a finished task survives another thread's waitAll(): its submitter may still wire to it
+    ran = 0;
+    auto alive = std::make_shared<int>(0);
+    auto kept = std::make_unique<Task>(0, [alive]() {});
+    Task* kept_raw = kept.get();
+    scheduler.submit(std::move(kept));
+    std::thread waiter([&scheduler]() { scheduler.waitAll(); });
+    waiter.join();
+    assert(alive.use_count() == 2 && kept_raw->getState() == TaskState::COMPLETED);
+    auto late = std::make_unique<Task>(1, count_run);
+    late->addDependency(kept_raw);
+    scheduler.submit(std::move(late));
+    scheduler.waitAll();
+    assert(ran == 1 && alive.use_count() == 1);
+
+    std::cout << "✅ Concurrent producer test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Admission control" << std::endl;
+
+    // at the task limit submit() would block: trySubmit() fails, or after its timeout
+    AdmissionLimits limits;
+    limits.max_tasks = 4;
+    scheduler.setAdmissionLimits(limits);
+    std::atomic<bool> gate_open{false};
+    auto gated = [&gate_open]() {
+        while (!gate_open) {
+            std::this_thread::yield();
+        }
+    };
+    for (int i = 0; i < 4; ++i) {
+        scheduler.submit(gated);
+    }
+    assert(scheduler.getAdmission().tasksInUse() == 4);
+    assert(!scheduler.trySubmit(count_run));
+    auto refused = std::make_unique<Task>(1, count_run);
+    [[maybe_unused]] auto before = std::chrono::steady_clock::now();
+    assert(!scheduler.trySubmit(std::move(refused), std::chrono::milliseconds(20)));
+    assert(std::chrono::steady_clock::now() - before >= std::chrono::milliseconds(20));
+    assert(refused); // not submitted, still ours
+    gate_open = true;
+    scheduler.waitAll();
+    assert(scheduler.getAdmission().tasksInUse() == 0);
+    assert(scheduler.trySubmit(std::move(refused)));
+    scheduler.waitAll();
+
+    // blocked producers are let in in the order they arrived (one task at a time here,
+    // so the tasks run in admission order)
+    limits.max_tasks = 1;
+    scheduler.setAdmissionLimits(limits);
+    gate_open = false;
+    scheduler.submit(gated);
+    std::vector<int> admitted;
+    std::mutex admitted_mutex;
+    std::vector<std::thread> blocked;
+    for (int p = 0; p < 4; ++p) {
+        blocked.emplace_back([&scheduler, &admitted, &admitted_mutex, p]() {
+            scheduler.submit([&admitted, &admitted_mutex, p]() {
+                std::lock_guard<std::mutex> lock(admitted_mutex);
+                admitted.push_back(p);
+            });
+        });
+        while (scheduler.getAdmission().waiting() < static_cast<size_t>(p + 1)) {
+            std::this_thread::yield();
+        }
+    }
+    gate_open = true;
+    for (auto& thread : blocked) {
+        thread.join();
+    }
+    scheduler.waitAll();
+    assert((admitted == std::vector<int>{0, 1, 2, 3}));
+
+    // workers never block: a task may spawn more tasks than the limit
+    ran = 0;
+    scheduler.submit([&scheduler, &count_run]() {
+        for (int i = 0; i < 10; ++i) {
+            scheduler.submit(count_run);
+        }
+    });
+    scheduler.waitAll();
+    assert(ran == 10);
+    assert(scheduler.getAdmission().tasksInUse() == 0);
+
+    // byte limit: tasks are charged sizeof(Task) plus their memory estimate
+    limits.max_tasks = 0;
+    limits.max_bytes = 2 * sizeof(Task) + 1500;
+    scheduler.setAdmissionLimits(limits);
+    gate_open = false;
+    Task* heavy = scheduler.createTask(1, gated);
+    heavy->setMemoryEstimate(1000);
+    scheduler.submit(heavy);
+    assert(scheduler.getAdmission().bytesInUse() == sizeof(Task) + 1000);
+    Task* second = scheduler.createTask(2, count_run);
+    second->setMemoryEstimate(1000);
+    assert(!scheduler.trySubmit(second));
+    assert(scheduler.trySubmit(count_run)); // a plain task still fits
+    gate_open = true;
+    assert(scheduler.trySubmit(second, std::chrono::seconds(10)));
+    scheduler.waitAll();
+    assert(scheduler.getAdmission().bytesInUse() == 0);
+
+    // a task larger than the whole limit is let in once nothing else is held
+    limits.max_bytes = 100;
+    scheduler.setAdmissionLimits(limits);
+    ran = 0;
+    scheduler.submit(count_run);
+    scheduler.submitBatch(std::vector<Task*>{scheduler.createTask(1, count_run), scheduler.createTask(2, count_run)});
+    scheduler.waitAll();
+    assert(ran == 3);
+    scheduler.setAdmissionLimits(AdmissionLimits{});
+
+    std::cout << "✅ Admission control test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Task results" << std::endl;
+
+    // values flow along the edges: consumers get their inputs' results as arguments
+    {
+        TaskResult<int> left = scheduler.submit([]() { return 20; });
+        TaskResult<int> right = scheduler.submit([]() { return 22; });
+        TaskResult<int> sum = scheduler.submit([](const int& a, const int& b) { return a + b; }, left, right);
+        TaskResult<std::string> text = scheduler.submit([](int value) { return std::to_string(value); }, sum);
+        TaskResult<void> done = scheduler.submit([]([[maybe_unused]] const std::string& value) { assert(value == "42"); }, text);
+        scheduler.waitAll();
+        assert(sum.get() == 42);
+        assert(left.get() == 20);
+        assert(text.get() == "42");
+        done.get();
+    }
+
+    // zero copy: by reference, or moved in; the result lives until the last handle and
+    // consumer are done with it
+    struct Payload {
+        static int& copies() {
+            static int count = 0;
+            return count;
+        }
+        static std::atomic<int>& alive() {
+            static std::atomic<int> count{0};
+            return count;
+        }
+        std::vector<int> data;
+        explicit Payload(int size): data(size, 1) {
+            alive()++;
+        }
+        Payload(const Payload& other): data(other.data) {
+            copies()++;
+            alive()++;
+        }
+        Payload(Payload&& other) noexcept: data(std::move(other.data)) {
+            alive()++;
+        }
+        ~Payload() {
+            alive()--;
+        }
+    };
+    {
+        std::atomic<bool> hold{true};
+        TaskResult<Payload> payload = scheduler.submit([&hold]() {
+            while (hold) {
+                std::this_thread::yield();
+            }
+            return Payload(1000);
+        });
+        auto total = [](const Payload& p) {
+            int sum = 0;
+            for (int value : p.data) {
+                sum += value;
+            }
+            return sum;
+        };
+        TaskResult<int> first = scheduler.submit(total, payload);
+        TaskResult<int> second = scheduler.submit(total, payload);
+        TaskResult<size_t> taken = scheduler.submit([](Payload p) { return p.data.size(); }, std::move(payload));
+        assert(!payload);
+        hold = false;
+        scheduler.waitAll();
+        assert(first.get() == 1000 && second.get() == 1000 && taken.get() == 1000);
+        assert(Payload::copies() == 0);
+        // no handle and no consumer left: the producer (and its value) is recycled already
+        assert(Payload::alive() == 0);
+
+        TaskResult<Payload> kept = scheduler.submit([]() { return Payload(10); });
+        TaskResult<int> reader = scheduler.submit(total, kept);
+        scheduler.waitAll();
+        assert(Payload::alive() == 1 && kept.get().data.size() == 10);
+        kept.reset();
+        assert(Payload::alive() == 0);
+    }
+
+    // large values go to the heap, a failed input fails its consumers
+    {
+        std::array<int, 64> big{};
+        big[63] = 7;
+        TaskResult<std::array<int, 64>> large = scheduler.submit([big]() { return big; });
+        TaskResult<int> last = scheduler.submit([](const std::array<int, 64>& values) { return values[63]; }, large);
+        TaskResult<int> broken = scheduler.submit([]() -> int { throw std::runtime_error("no value"); });
+        TaskResult<int> skipped = scheduler.submit([](int value) { return value + 1; }, broken);
+        try {
+            scheduler.waitAll();
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(last.get() == 7);
+        assert(skipped.task()->getState() == TaskState::CANCELLED);
+        [[maybe_unused]] bool threw = false;
+        try {
+            broken.get();
+        } catch (const std::runtime_error& error) {
+            threw = std::string(error.what()) == "no value";
+        }
+        assert(threw);
+
+        scheduler.setFailurePolicy(FailurePolicy::RUN_DEPENDENTS);
+        broken = scheduler.submit([]() -> int { throw std::runtime_error("no value"); });
+        skipped = scheduler.submit([](int value) { return value + 1; }, broken);
+        try {
+            scheduler.waitAll();
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(skipped.task()->getState() == TaskState::FAILED);
+        scheduler.setFailurePolicy(FailurePolicy::SKIP_DEPENDENTS);
+    }
+
+    std::cout << "✅ Task result test passed!" << std::endl;
+
+
+    std::cout << "\nTest: Blocking tasks" << std::endl;
+
+    // a blocking load runs in the lane, its consumers are released into the CPU workers
+    for (SchedulingPolicy policy : {SchedulingPolicy::FIFO, SchedulingPolicy::CRITICAL_PATH}) {
+        scheduler.setSchedulingPolicy(policy);
+        std::atomic<int> load_worker{-2};
+        std::atomic<int> consumer_worker{-2};
+        TaskResult<std::vector<int>> loaded = scheduler.submitBlocking([&scheduler, &load_worker]() {
+            load_worker = scheduler.currentWorker();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return std::vector<int>(100, 2);
+        });
+        TaskResult<int> total = scheduler.submit([&scheduler, &consumer_worker](const std::vector<int>& values) {
+            consumer_worker = scheduler.currentWorker();
+            int sum = 0;
+            for (int value : values) {
+                sum += value;
+            }
+            return sum;
+        }, loaded);
+        Task* blocking = scheduler.createTask(1, count_run);
+        blocking->setBlocking(true);
+        ran = 0;
+        scheduler.submitBatch(std::vector<Task*>{blocking, scheduler.createTask(2, count_run)});
+        scheduler.waitAll();
+        assert(total.get() == 200 && ran == 2);
+        assert(load_worker.load() == -1);
+        assert(consumer_worker.load() >= 0);
+    }
+    scheduler.setSchedulingPolicy(SchedulingPolicy::FIFO);
+
+    std::cout << "✅ Blocking task test passed!" << std::endl;
+
+    std::cout << "\nTest: Graph snapshots" << std::endl;
+
+    // kernel 0 adds its parameter to the node's slot, kernel 1 also checks that its
+    // dependencies ran first, kernel 2 throws
+    std::atomic<int> slots[16] = {};
+    std::atomic<bool> deps_ok{true};
+    KernelRegistry registry;
+    registry.add(0, [&slots](const KernelParams& params) {
+        slots[params.node].fetch_add(params.as<int>());
+    });
+    registry.add(1, [&slots, &deps_ok](const KernelParams& params) {
+        for (size_t i = 0; i < params.size / sizeof(uint32_t); ++i) {
+            uint32_t dep;
+            std::memcpy(&dep, static_cast<const unsigned char*>(params.data) + i * sizeof(dep), sizeof(dep));
+            if (slots[dep].load() <= slots[params.node].load()) {
+                deps_ok = false;
+            }
+        }
+        slots[params.node].fetch_add(1);
+    });
+    registry.add(2, [](const KernelParams&) {
+        throw std::runtime_error("kernel failed");
+    });
+
+    // 4 sources (params 1..4) -> 8 checkers -> 1 checker sink
+    TaskGraph kernels;
+    std::vector<uint32_t> snapshot_sources, snapshot_checkers;
+    for (int i = 0; i < 4; ++i) {
+        int amount = i + 1;
+        snapshot_sources.push_back(static_cast<uint32_t>(kernels.addNode(registry, 0, &amount, sizeof(amount))));
+    }
+    for (int i = 0; i < 8; ++i) {
+        uint32_t deps[2] = {snapshot_sources[i % 4], snapshot_sources[(i + 1) % 4]};
+        size_t node = kernels.addNode(registry, 1, deps, sizeof(deps));
+        kernels.addDependency(node, deps[0]);
+        kernels.addDependency(node, deps[1]);
+        snapshot_checkers.push_back(static_cast<uint32_t>(node));
+    }
+    size_t snapshot_sink = kernels.addNode(registry, 1, snapshot_checkers.data(),
+                                           snapshot_checkers.size() * sizeof(uint32_t));
+    for (uint32_t node : snapshot_checkers) {
+        kernels.addDependency(snapshot_sink, node);
+    }
+    // the in-memory graph runs the same kernels
+    assert(scheduler.run(kernels));
+    assert(deps_ok && slots[3] == 4 && slots[snapshot_sink] == 1);
+
+    char snapshot_path[] = "/tmp/test_snapshotXXXXXX";
+    int snapshot_fd = mkstemp(snapshot_path);
+    assert(snapshot_fd >= 0);
+    close(snapshot_fd);
+    assert(GraphSnapshot::write(kernels, snapshot_path));
+    {
+        GraphSnapshot snapshot;
+        assert(snapshot.open(snapshot_path));
+        assert(snapshot.size() == 13 && snapshot.numEdges() == 24 && snapshot.numRoots() == 4);
+        assert(snapshot.node(snapshot_sources[0]).rank == kernels.task(snapshot_sources[0]).getRank());
+        for (SchedulingPolicy policy : {SchedulingPolicy::FIFO, SchedulingPolicy::CRITICAL_PATH}) {
+            scheduler.setSchedulingPolicy(policy);
+            for (int run = 0; run < 100; ++run) {
+                scheduler.run(snapshot, registry);
+            }
+        }
+        scheduler.setSchedulingPolicy(SchedulingPolicy::FIFO);
+        assert(deps_ok && slots[0] == 201 && slots[3] == 804 && slots[snapshot_sink] == 201);
+
+        // under a task limit below the number of roots the run still finishes, and every
+        // node hands back what it was charged
+        AdmissionLimits snapshot_limits;
+        snapshot_limits.max_tasks = 2;
+        scheduler.setAdmissionLimits(snapshot_limits);
+        scheduler.run(snapshot, registry);
+        assert(scheduler.getAdmission().tasksInUse() == 0 && scheduler.getAdmission().bytesInUse() == 0);
+        scheduler.setAdmissionLimits(AdmissionLimits{});
+        assert(deps_ok && slots[snapshot_sink] == 202);
+    }
+
+    // a failing kernel skips its dependents, a missing one fails its node
+    TaskGraph failing;
+    int one = 1;
+    size_t thrower = failing.addNode(registry, 2);
+    size_t skipped = failing.addNode(registry, 0, &one, sizeof(one));
+    failing.addNode(registry, 7); // never registered
+    failing.addDependency(skipped, thrower);
+    assert(GraphSnapshot::write(failing, snapshot_path));
+    {
+        GraphSnapshot snapshot;
+        assert(snapshot.open(snapshot_path));
+        slots[skipped] = 0;
+        [[maybe_unused]] bool threw = false;
+        try {
+            scheduler.run(snapshot, registry);
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        assert(threw && slots[skipped] == 0 && scheduler.getErrors().size() == 2);
+    }
+
+    // blobs are packed unaligned: a double after a 1-byte blob still reads back, in memory
+    // and mapped; a blob of the wrong size fails its node
+    std::atomic<double> unaligned_sum{0.0};
+    registry.add(3, [&unaligned_sum](const KernelParams& params) {
+        double expected = unaligned_sum.load();
+        while (!unaligned_sum.compare_exchange_weak(expected, expected + params.as<double>())) {
+        }
+    });
+    TaskGraph unaligned;
+    char tag = 'x';
+    double half = 0.5;
+    unaligned.addNode(registry, 3, &tag, sizeof(tag));
+    unaligned.addNode(registry, 3, &half, sizeof(half));
+    [[maybe_unused]] bool size_rejected = false;
+    try {
+        scheduler.run(unaligned);
+    } catch (const std::invalid_argument&) {
+        size_rejected = true;
+    }
+    assert(size_rejected && unaligned_sum.load() == 0.5);
+    assert(GraphSnapshot::write(unaligned, snapshot_path));
+    {
+        GraphSnapshot snapshot;
+        assert(snapshot.open(snapshot_path));
+        size_rejected = false;
+        try {
+            scheduler.run(snapshot, registry);
+        } catch (const std::invalid_argument&) {
+            size_rejected = true;
+        }
+        assert(size_rejected && unaligned_sum.load() == 1.0);
+    }
+
+    // headers whose counts do not fit the file are rejected
+    assert(GraphSnapshot::write(kernels, snapshot_path));
+    std::string valid_file;
+    {
+        std::ifstream in(snapshot_path, std::ios::binary);
+        valid_file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    SnapshotHeader valid_header;
+    std::memcpy(&valid_header, valid_file.data(), sizeof(valid_header));
+    [[maybe_unused]] auto opensPatched = [&](const SnapshotHeader& header, std::string file) {
+        std::memcpy(&file[0], &header, sizeof(header));
+        std::ofstream(snapshot_path, std::ios::binary | std::ios::trunc) << file;
+        GraphSnapshot snapshot;
+        return snapshot.open(snapshot_path);
+    };
+    assert(opensPatched(valid_header, valid_file));
+    SnapshotHeader bad = valid_header;
+    bad.num_roots = bad.num_nodes + 1;
+    assert(!opensPatched(bad, valid_file));
+    bad = valid_header;
+    bad.param_bytes = UINT64_MAX - 3; // section sizes would overflow
+    assert(!opensPatched(bad, valid_file));
+    // no roots: consistent sizes, but a run would wait forever
+    bad = valid_header;
+    bad.num_roots = 0;
+    bad.file_size -= 16;
+    std::string rootless = valid_file;
+    rootless.erase(valid_file.size() - ((valid_header.param_bytes + 7) & ~uint64_t(7)) - 16, 16);
+    assert(!opensPatched(bad, rootless));
+    // successor offsets that end elsewhere than at num_edges
+    std::string bad_offsets = valid_file;
+    uint32_t edges_end = static_cast<uint32_t>(valid_header.num_edges + 1);
+    std::memcpy(&bad_offsets[sizeof(SnapshotHeader) + valid_header.num_nodes * sizeof(SnapshotNode) +
+                             valid_header.num_nodes * sizeof(uint32_t)], &edges_end, sizeof(edges_end));
+    assert(!opensPatched(valid_header, bad_offsets));
+
+    // sections of the right size whose data would lead a run out of bounds (or never end)
+    auto align8 = [](size_t bytes) { return (bytes + 7) & ~size_t(7); };
+    size_t nodes_at = sizeof(SnapshotHeader);
+    size_t offsets_at = nodes_at + align8(valid_header.num_nodes * sizeof(SnapshotNode));
+    size_t successors_at = offsets_at + align8((valid_header.num_nodes + 1) * sizeof(uint32_t));
+    size_t roots_at = successors_at + align8(valid_header.num_edges * sizeof(uint32_t));
+    [[maybe_unused]] auto opensCorrupted = [&](size_t at, const void* value, size_t size) {
+        std::string file = valid_file;
+        std::memcpy(&file[at], value, size);
+        return opensPatched(valid_header, file);
+    };
+    uint32_t out_of_range = static_cast<uint32_t>(valid_header.num_nodes);
+    uint32_t descending = 1000;
+    int32_t bad_priority = static_cast<int32_t>(NUM_PRIORITIES);
+    uint64_t past_params = valid_header.param_bytes;
+    uint32_t first_root = snapshot_sources[0];
+    SnapshotNode sink_entry;
+    std::memcpy(&sink_entry, &valid_file[nodes_at + snapshot_sink * sizeof(SnapshotNode)], sizeof(sink_entry));
+    uint32_t sink_in_degree = sink_entry.in_degree + 1;
+    assert(!opensCorrupted(offsets_at + sizeof(uint32_t), &descending, sizeof(descending)));
+    assert(!opensCorrupted(successors_at, &out_of_range, sizeof(out_of_range)));
+    assert(!opensCorrupted(roots_at, &out_of_range, sizeof(out_of_range)));
+    assert(!opensCorrupted(roots_at + sizeof(uint32_t), &first_root, sizeof(first_root))); // listed twice
+    assert(!opensCorrupted(nodes_at + offsetof(SnapshotNode, priority), &bad_priority, sizeof(bad_priority)));
+    assert(!opensCorrupted(nodes_at + offsetof(SnapshotNode, param_offset), &past_params, sizeof(past_params)));
+    assert(!opensCorrupted(nodes_at + snapshot_sink * sizeof(SnapshotNode) + offsetof(SnapshotNode, in_degree),
+                           &sink_in_degree, sizeof(sink_in_degree)));
+
+    // graphs with TaskWork nodes cannot be saved, other files are not snapshots
+    assert(!GraphSnapshot::write(graph, snapshot_path));
+    {
+        std::ofstream garbage(snapshot_path, std::ios::trunc);
+        garbage << "not a snapshot, but long enough to hold a header ........................";
+    }
+    GraphSnapshot rejected;
+    assert(!rejected.open(snapshot_path) && !rejected.isOpen());
+    assert(!rejected.open("/nonexistent/snapshot"));
+    std::remove(snapshot_path);
+
+    std::cout << "✅ Graph snapshot test passed!" << std::endl;
     return 0;
 }
\ No newline at end of file
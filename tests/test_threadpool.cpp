@@ -4,6 +4,11 @@
 #include "task.h"
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 int main() {
     std::cout << "Test 1: 100 incrementations of a counter with 4 threads." << std::endl;
@@ -64,4 +69,409 @@ int main() {
     auto duration2 = std::chrono::duration_cast<std::chrono::milliseconds>(end2 - start2);
     std::cout << "✅ Test 2 passed" << std::endl;
     std::cout << "1000 tasks took " << duration2.count() << "ms" << std::endl;
-}
\ No newline at end of file
+
+
+    std::cout << "Test 3: Nested submission in both pool modes (local deques + stealing)." << std::endl;
+
+    for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+        std::atomic<int> counter3{0};
+        std::vector<std::unique_ptr<Task>> children; // outlive the pool's threads
+        std::vector<std::unique_ptr<Task>> parents;
+        ThreadPool threads3(4, mode);
+
+        for (int i = 0; i < 1000; ++i) {
+            children.push_back(std::make_unique<Task>(i, [&counter3]() {
+                counter3.fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+        // each parent submits 10 children from inside a worker
+        for (int i = 0; i < 100; ++i) {
+            parents.push_back(std::make_unique<Task>(1000 + i, [&threads3, &children, i]() {
+                assert(threads3.currentWorker() >= 0);
+                for (int j = 0; j < 10; ++j) {
+                    threads3.submit(children[i * 10 + j].get());
+                }
+            }));
+        }
+        assert(threads3.currentWorker() == -1);
+        for (auto& task : parents) {
+            threads3.submit(task.get());
+        }
+
+        for (auto& task : children) {
+            while (task->getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+        }
+        assert(counter3 == 1000);
+    }
+    std::cout << "✅ Test 3 passed" << std::endl;
+
+
+    std::cout << "Test 4: Priority classes and aging." << std::endl;
+
+    for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+        std::atomic<bool> gate_open{false};
+        std::mutex order_mutex;
+        std::vector<uint64_t> order;
+
+        auto record = [&order, &order_mutex](uint64_t id) {
+            return [&order, &order_mutex, id]() {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(id);
+            };
+        };
+        auto gate_work = [&gate_open]() {
+            while (!gate_open.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        };
+
+        // the tasks outlive the pool's threads
+        Task gate(0, gate_work);
+        Task low(1, record(1));
+        low.setPriority(TaskPriority::LOW);
+        Task normal(2, record(2));
+        Task high(3, record(3));
+        high.setPriority(TaskPriority::HIGH);
+        Task gate2(10, gate_work);
+        std::vector<std::unique_ptr<Task>> backlog;
+        Task starving(200, record(200));
+        starving.setPriority(TaskPriority::LOW);
+        ThreadPool single(1, mode);
+
+        // keep the only worker busy until everything is queued
+        single.submit(&gate);
+        while (gate.getState() == TaskState::PENDING) {
+            std::this_thread::yield();
+        }
+
+        single.submit(&low);
+        single.submit(&normal);
+        single.submit(&high);
+        gate_open.store(true, std::memory_order_release);
+
+        while (low.getState() != TaskState::COMPLETED) {
+            std::this_thread::yield();
+        }
+        assert((order == std::vector<uint64_t>{3, 2, 1}));
+
+        // aging: with a limit of 2 the LOW task overtakes a backlog of HIGH tasks
+        single.setAgingLimit(2);
+        order.clear();
+        gate_open.store(false, std::memory_order_release);
+        single.submit(&gate2);
+        while (gate2.getState() == TaskState::PENDING) {
+            std::this_thread::yield();
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            backlog.push_back(std::make_unique<Task>(100 + i, record(100 + i)));
+            backlog.back()->setPriority(TaskPriority::HIGH);
+            single.submit(backlog.back().get());
+        }
+        single.submit(&starving);
+        gate_open.store(true, std::memory_order_release);
+
+        for (auto& task : backlog) {
+            while (task->getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+        }
+        while (starving.getState() != TaskState::COMPLETED) {
+            std::this_thread::yield();
+        }
+        [[maybe_unused]] size_t position = std::find(order.begin(), order.end(), 200) - order.begin();
+        assert(position <= 2);
+    }
+    std::cout << "✅ Test 4 passed" << std::endl;
+
+
+    std::cout << "\nTest 5: Pinned workers and NUMA locality hints" << std::endl;
+    {
+        assert((parseCpuList("0-2,5,7-8") == std::vector<int>{0, 1, 2, 5, 7, 8}));
+        assert(parseCpuList("x").empty());
+
+        Topology topology;
+        assert(topology.numNodes() >= 1);
+        int first_cpu = topology.nodes()[0].cpus[0];
+
+        // explicit cpu list: every worker runs on the cpu it was given
+        ThreadPoolOptions options;
+        options.pin_workers = true;
+        options.cpus = {first_cpu};
+        std::atomic<int> on_cpu{0};
+        std::vector<std::unique_ptr<Task>> hinted; // outlive the pool's threads
+        ThreadPool pinned(2, options);
+        assert(pinned.getWorkerCpu(0) == first_cpu && pinned.getWorkerCpu(1) == first_cpu);
+
+        for (int i = 0; i < 50; ++i) {
+            hinted.push_back(std::make_unique<Task>(i, [&pinned, &on_cpu]() {
+                int worker = pinned.currentWorker();
+                if (worker >= 0 && currentCpu() == pinned.getWorkerCpu(worker)) {
+                    on_cpu.fetch_add(1, std::memory_order_relaxed);
+                }
+            }));
+            hinted.back()->setNumaNode(i % static_cast<int>(pinned.getNumNodes()));
+            pinned.submit(hinted.back().get());
+        }
+        for (auto& task : hinted) {
+            while (task->getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+        }
+        assert(on_cpu == 50);
+
+        // topology placement: workers are dealt over the nodes
+        options.cpus.clear();
+        ThreadPool spread(4, options);
+        assert(spread.getNumNodes() == topology.numNodes());
+        for (size_t i = 0; i < 4; ++i) {
+            assert(spread.getWorkerNode(i) == topology.nodeOfCpu(spread.getWorkerCpu(i)));
+        }
+    }
+    std::cout << "✅ Test 5 passed" << std::endl;
+
+
+    std::cout << "\nTest 6: Statistics and latency histograms" << std::endl;
+    {
+        LatencyHistogram histogram;
+        for (uint64_t value = 1; value <= 1000; ++value) {
+            histogram.record(value);
+        }
+        assert(histogram.count() == 1000 && histogram.max() == 1000);
+        assert(histogram.mean() == 500.5);
+        // buckets are 1/16 of their power of two wide
+        [[maybe_unused]] uint64_t median = histogram.percentile(0.5);
+        assert(median >= 500 && median <= 500 + 500 / 16);
+        assert(histogram.percentile(1.0) == 1000 && histogram.percentile(0.0) == 1);
+
+        for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+            ThreadPoolOptions options;
+            options.mode = mode;
+            options.collect_stats = true;
+            options.stats_sample_period = 1; // time every task
+            Task untracked(1000, []() {}); // the tasks outlive the pool's workers
+            std::vector<std::unique_ptr<Task>> tasks;
+            ThreadPool pool(2, options);
+            for (int i = 0; i < 200; ++i) {
+                tasks.push_back(std::make_unique<Task>(i, []() {
+                    volatile int x = 0;
+                    for (int j = 0; j < 1000; ++j) {
+                        x += j;
+                    }
+                }));
+                pool.submit(tasks.back().get());
+            }
+            // counters are updated around each task, wait for the last ones
+            SchedulerStats stats = pool.getStats();
+            while (stats.total.get(StatCounter::TASKS_EXECUTED) < 200 || stats.total.run_time.count() < 200) {
+                std::this_thread::yield();
+                stats = pool.getStats();
+            }
+            assert(stats.workers.size() == 3);
+            assert(stats.total.get(StatCounter::TASKS_EXECUTED) == 200);
+            assert(stats.total.run_time.count() == 200 && stats.total.queue_wait.count() == 200);
+            assert(stats.total.get(StatCounter::BUSY_NS) > 0);
+            [[maybe_unused]] uint64_t picks = stats.total.get(StatCounter::LOCAL_POPS) + stats.total.get(StatCounter::INJECTED_POPS)
+                           + stats.total.get(StatCounter::STEALS);
+            assert(picks == 200);
+            // the external submitter took the shared queue's lock for every task; work-stealing
+            // injection goes through the ring without a queue lock (waking a parked worker
+            // takes queue_mutex_ for the handshake only, which is not counted)
+            if (mode == PoolMode::SHARED_QUEUE) {
+                assert(stats.workers[2].get(StatCounter::LOCK_ACQUISITIONS) >= 200);
+            } else {
+                assert(stats.workers[2].get(StatCounter::LOCK_ACQUISITIONS) == 0);
+            }
+            assert(stats.total.get(StatCounter::LOCK_CONTENDED) <= stats.total.get(StatCounter::LOCK_ACQUISITIONS));
+
+            // switched off: nothing is counted anymore
+            pool.setStatsEnabled(false);
+            pool.submit(&untracked);
+            while (untracked.getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+            assert(pool.getStats().total.get(StatCounter::TASKS_EXECUTED) == 200);
+        }
+
+        // an external batch larger than the injection ring takes one queue lock per node
+        // for its overflow (work-stealing) or one for the whole batch (shared queue)
+        for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+            ThreadPoolOptions options;
+            options.mode = mode;
+            options.collect_stats = true;
+            options.injection_capacity = 64;
+            std::atomic<int> executed{0};
+            std::vector<std::unique_ptr<Task>> batch; // outlive the pool's workers
+            std::vector<Task*> raw;
+            for (int i = 0; i < 1000; ++i) {
+                batch.push_back(std::make_unique<Task>(i, [&executed]() {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                }));
+                raw.push_back(batch.back().get());
+            }
+            ThreadPool pool(2, options);
+            pool.submitBatch(raw.data(), raw.size());
+            while (executed.load() < 1000) {
+                std::this_thread::yield();
+            }
+            for (auto& task : batch) {
+                while (task->getState() != TaskState::COMPLETED) {
+                    std::this_thread::yield();
+                }
+            }
+            [[maybe_unused]] uint64_t locks = pool.getStats().workers[2].get(StatCounter::LOCK_ACQUISITIONS);
+            assert(locks >= 1 && locks <= pool.getNumNodes());
+        }
+    }
+    std::cout << "✅ Test 6 passed" << std::endl;
+
+
+    std::cout << "\nTest 7: Lock-free injection from concurrent producers" << std::endl;
+    {
+        // bounded MPMC ring: FIFO, push fails when full
+        Task items[3] = {Task(0, []() {}), Task(1, []() {}), Task(2, []() {})};
+        MpmcQueue<Task> ring(2);
+        assert(ring.capacity() == 2 && ring.pop() == nullptr);
+        assert(ring.push(&items[0]) && ring.push(&items[1]) && !ring.push(&items[2]));
+        assert(ring.size() == 2 && ring.pop() == &items[0]);
+        assert(ring.push(&items[2]) && ring.pop() == &items[1] && ring.pop() == &items[2]);
+
+        // bulk push: the prefix that fits, in order
+        MpmcQueue<Task> bulk(2);
+        Task* batch[3] = {&items[0], &items[1], &items[2]};
+        assert(bulk.pushBulk(batch, 3) == 2 && bulk.pushBulk(batch + 2, 1) == 0);
+        assert(bulk.pop() == &items[0] && bulk.pushBulk(batch + 2, 1) == 1);
+        assert(bulk.pop() == &items[1] && bulk.pop() == &items[2] && bulk.pop() == nullptr);
+
+        // producers outside the pool; a tiny ring makes most tasks take the overflow queue
+        ThreadPoolOptions options;
+        options.injection_capacity = 4;
+        std::atomic<int> executed{0};
+        std::vector<std::unique_ptr<Task>> produced(4 * 2500); // outlive the pool's workers
+        ThreadPool pool(2, options);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p) {
+            producers.emplace_back([&, p]() {
+                for (int i = p * 2500; i < (p + 1) * 2500; ++i) {
+                    produced[i] = std::make_unique<Task>(i, [&executed]() {
+                        executed.fetch_add(1, std::memory_order_relaxed);
+                    });
+                    pool.submit(produced[i].get());
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        while (executed.load() < 10000) {
+            std::this_thread::yield();
+        }
+        for (auto& task : produced) {
+            while (task->getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    std::cout << "✅ Test 7 passed" << std::endl;
+
+    std::cout << "\nTest 8: Blocking tasks run in their own lane" << std::endl;
+    {
+        // four blocking tasks wait for a compute task submitted after them: on the single
+        // worker this would never finish, in a lane of two threads it does
+        ThreadPoolOptions options;
+        options.blocking_threads = 2;
+        options.blocking_keep_alive = std::chrono::milliseconds(10);
+        std::atomic<bool> released{false};
+        std::atomic<int> done{0};
+        std::vector<std::unique_ptr<Task>> tasks; // outlive the pool's threads
+        for (int i = 0; i < 4; ++i) {
+            tasks.push_back(std::make_unique<Task>(i, [&]() {
+                while (!released) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                done.fetch_add(1);
+            }));
+            tasks.back()->setBlocking(true);
+        }
+        tasks.push_back(std::make_unique<Task>(4, [&released]() { released = true; }));
+        ThreadPool pool(1, options);
+        std::vector<Task*> blocking = {tasks[0].get(), tasks[1].get()};
+        pool.submitBatch(blocking.data(), blocking.size());
+        pool.submit(tasks[2].get());
+        pool.submit(tasks[3].get());
+        pool.submit(tasks[4].get());
+        while (done.load() < 4) {
+            std::this_thread::yield();
+        }
+        assert(pool.getBlockingLane()->peakThreads() == 2);
+        // idle lane threads go away after the keep-alive
+        while (pool.getBlockingLane()->numThreads() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // without a lane blocking tasks run on the workers
+        options.blocking_threads = 0;
+        std::atomic<int> worker{-2};
+        ThreadPool* plain_pool = nullptr;
+        Task probe(6, [&]() { worker = plain_pool->currentWorker(); });
+        probe.setBlocking(true);
+        ThreadPool plain(1, options);
+        plain_pool = &plain;
+        plain.submit(&probe);
+        while (worker.load() == -2) {
+            std::this_thread::yield();
+        }
+        assert(plain.getBlockingLane() == nullptr && worker.load() == 0);
+        while (probe.getState() != TaskState::COMPLETED) {
+            std::this_thread::yield();
+        }
+    }
+    std::cout << "✅ Test 8 passed" << std::endl;
+
+    std::cout << "\nTest 9: Spinning workers do not swallow the wakeups of a burst" << std::endl;
+    for (PoolMode mode : {PoolMode::SHARED_QUEUE, PoolMode::WORK_STEALING}) {
+        // one worker spins after its task, the other three are parked; the burst only
+        // finishes if all four of its tasks run at the same time
+        ThreadPoolOptions options;
+        options.mode = mode;
+        options.idle = IdlePolicy::spinThenPark(200000, 0);
+        std::atomic<int> running{0};
+        std::atomic<bool> together{true};
+        std::vector<std::unique_ptr<Task>> burst; // outlive the pool's workers
+        for (int i = 0; i < 4; ++i) {
+            burst.push_back(std::make_unique<Task>(i, [&running, &together]() {
+                running.fetch_add(1);
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (running.load() < 4 && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                }
+                together = together && running.load() >= 4;
+            }));
+        }
+        std::atomic<bool> warmed{false};
+        Task warm(4, [&warmed]() { warmed = true; });
+        ThreadPool pool(4, options);
+        while (pool.getStats().spinning_workers > 0 || pool.getStats().sleeping_workers < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pool.submit(&warm);
+        while (!warmed) {
+            std::this_thread::yield();
+        }
+        for (auto& task : burst) {
+            pool.submit(task.get());
+        }
+        for (auto& task : burst) {
+            while (task->getState() != TaskState::COMPLETED) {
+                std::this_thread::yield();
+            }
+        }
+        assert(together);
+        while (warm.getState() != TaskState::COMPLETED) {
+            std::this_thread::yield();
+        }
+    }
+    std::cout << "✅ Test 9 passed" << std::endl;
+}